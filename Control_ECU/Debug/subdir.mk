@@ -6,35 +6,62 @@
 C_SRCS += \
 ../buzzer.c \
 ../control_main.c \
+../credentials.c \
 ../dc_motor.c \
+../door_lock.c \
 ../external_eeprom.c \
 ../gpio.c \
 ../i2c.c \
+../idle.c \
+../journal.c \
+../link.c \
+../profiler.c \
 ../pwm_timer0.c \
+../scheduler.c \
+../sw_timer.c \
 ../timer1.c \
-../uart.c 
+../uart.c \
+../uptime.c 
 
 OBJS += \
 ./buzzer.o \
 ./control_main.o \
+./credentials.o \
 ./dc_motor.o \
+./door_lock.o \
 ./external_eeprom.o \
 ./gpio.o \
 ./i2c.o \
+./idle.o \
+./journal.o \
+./link.o \
+./profiler.o \
 ./pwm_timer0.o \
+./scheduler.o \
+./sw_timer.o \
 ./timer1.o \
-./uart.o 
+./uart.o \
+./uptime.o 
 
 C_DEPS += \
 ./buzzer.d \
 ./control_main.d \
+./credentials.d \
 ./dc_motor.d \
+./door_lock.d \
 ./external_eeprom.d \
 ./gpio.d \
 ./i2c.d \
+./idle.d \
+./journal.d \
+./link.d \
+./profiler.d \
 ./pwm_timer0.d \
+./scheduler.d \
+./sw_timer.d \
 ./timer1.d \
-./uart.d 
+./uart.d \
+./uptime.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -6,40 +6,46 @@
  */
 
 #include <avr/io.h>
-#include <util/delay.h>
+#include <util/atomic.h>
 #include "buzzer.h"
-#include "external_eeprom.h"
+#include "credentials.h"
 #include "dc_motor.h"
+#include "door_lock.h"
 #include "uart.h"
+#include "link.h"
 #include "i2c.h"
-#include "timer1.h"
+#include "sw_timer.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "idle.h"
+#include "uptime.h"
 #include "common_macros.h"
 
 /*******************************************************************************
- *                                Definitions                                  *
+ *                               Enumerations                                  *
  *******************************************************************************/
-#define WRONG_BYTE            'w'  /* Byte defines wrong data sent to control_MCU */
-#define CONFIRM_BYTE          'c'  /* Byte defines correct data sent to control_MCU */
-#define REPEAT_BYTE           'r'  /* Byte defines wrong data sent to control_MCU and asks for repeating it */
-#define EEPROM_ADDRESS         0   /* First Address in EEPROM Password */
+
+/* Scheduler events, the door timer first as the motor and the buzzer must not wait for the link */
+typedef enum
+{
+	EVENT_DOOR_TIMER, EVENT_PASSWORD_SAVED, EVENT_LINK_RX
+} Control_EventId;
 
 /*******************************************************************************
  *                                    Globals                                  *
  *******************************************************************************/
 
-/* defines if matching between passwords occurs or not */
-uint8 g_matchingFlag = 0;
+/* An EVENT_LINK_RX is queued, so the RX ISR does not queue one per byte */
+static volatile bool g_linkRxPosted = FALSE;
 
-uint8 g_passArray [8] = {'.', '.', '.', '.', '.', '.', '.', '.'};         /* Array contains the new password */
-uint8 g_repeatedPassArray [8] = {'.', '.', '.', '.', '.', '.', '.', '.'}; /* Array contains the confirm password */
-uint8 g_definedPassArray [8] = {'.', '.', '.', '.', '.', '.', '.', '.'};  /* Array contains the user input system password */
+/* Uptime when the scheduler started, sent with the status */
+static uint16 g_bootMs = 0;
 
-/*Timer configuration for 15 sec */
-TIMER1_ConfigType s_timerConfigurations_15Sec = {13885, 0, FCPU_1024, NORMAL};
-/*Timer configuration for 3 sec */
-TIMER1_ConfigType s_timerConfigurations_3Sec = {42099, 0, FCPU_1024, NORMAL};
-/*Timer configuration for 1 min */
-TIMER1_ConfigType s_timerConfigurations_60Sec = {55538, 0, FCPU_1024, NORMAL};
+/* Last request taken from HMI_ECU and its reply, a resent copy of it gets the same reply again */
+static bool g_hasRequest = FALSE;
+static uint8 g_requestSequence = 0;
+static bool g_replyPending = FALSE;            /* Answered when the new password write ends */
+static LINK_FrameType g_reply;
 
 /*******************************************************************************
  *                             Functions Prototypes                            *
@@ -47,45 +53,33 @@ TIMER1_ConfigType s_timerConfigurations_60Sec = {55538, 0, FCPU_1024, NORMAL};
 
 /*
  * Description:
- * 1. Receive the new password and its confirmation from HMI_ECU.
- * 2. Compare the 2 passwords.
- * 3. If matched, send the confirm byte to HMI_ECU and save the password in EEPROM.
- * 4. If not matched, send the wrong byte to HMI_ECU and repeat again.
+ * ISR side call backs, they only post the matching event to the scheduler.
  */
-void recieveCheckNewPassword (void);
+void linkByteReceived (void);
+void doorTimerExpired (void);
+void passwordSaved (void);
 
 /*
  * Description:
- * 1. Receive the user input password for selecting either open door or change pass from HMI_ECU.
- * 2. Compare it with the password saved in EEPROM.
- * 3. If matched, receive the user choice byte and if '+' rotate the motor, if '-' change password.
- * 4. If not matched, send repeat byte to HMI_ECU to ask for password 2 more times.
- * 5. If matched in the 2 next iterations take the action.
- * 6. If not matched in the 3 iterations, send wrong byte to HMI_ECU and start the buzzer.
+ * Scheduler handlers, each one runs to completion without blocking and feeds the door lock state machine.
  */
-void getDefinedPassword (void);
+void onDoorTimer (uint8 param);
+void onPasswordSaved (uint8 param);
+void onLinkRx (uint8 param);
 
 /*
  * Description:
- * Timer1 first call back function after counting 15 seconds:
- * 1. First call stops the motor for 3 seconds after 15 seconds and initialize the timer for counting 3 seconds.
- * 2. Second call stops the motor after gate is closed and de-initialise the timer.
+ * Answer the startup handshake of HMI_ECU with the password state and the boot time.
+ * Also the answer of the requests the door lock cannot take now, HMI_ECU follows the status.
  */
-void timerCallBack_15Sec (void);
+void sendStatus (void);
 
 /*
  * Description:
- * Timer1 second call back function after counting 3 seconds:
- * 1. After being called initialize the timer for counting another 15 seconds for the door to start locking.
+ * Take a new password or an authenticate request once, a copy with the sequence
+ * of the last request is a resend after a lost reply and gets that reply again.
  */
-void timerCallBack_3Sec (void);
-
-/*
- * Description:
- * Timer1 third call back function after counting 1 minute:
- * 1. After being called stops the buzzer ringing which started when 3 consecutive passwords are wrong.
- */
-void timerCallBack_60Sec (void);
+void handleRequest (const LINK_FrameType *frame);
 
 
 int main (void)
@@ -98,21 +92,28 @@ int main (void)
 	/* UART configurations with 8 Bits data, No parity, one stop bit and 9600 baud rate*/
 	UART_ConfigType s_uartConfiguration = {EIGHT_BITS, DISABLED, ONE_BIT, 9600};
 	UART_init (&s_uartConfiguration);
-	SET_BIT (SREG, 7);												/* Enable I-bit */
+	LINK_init ();
+	SWTIMER_init ();												/* Start the software timers tick */
+	PROF_init ();													/* Calibrate the profiler on the tick */
+	IDLE_init ();													/* Sleep between the events */
+	DOOR_init (doorTimerExpired, passwordSaved);					/* Wait for the first password */
 
-	for(;;)
+	SCHED_init ();
+	SCHED_register (EVENT_DOOR_TIMER, SCHED_PRIORITY_HIGH, onDoorTimer);
+	SCHED_register (EVENT_PASSWORD_SAVED, SCHED_PRIORITY_NORMAL, onPasswordSaved);
+	SCHED_register (EVENT_LINK_RX, SCHED_PRIORITY_LOW, onLinkRx);
+	UART_setRxCallBack (linkByteReceived);
+
+	SET_BIT (SREG, 7);												/* Enable I-bit */
+	if (CRED_init ())												/* Load the stored password, needs the TWI interrupt */
 	{
-		/* When there is no matching between new and confirmation passwords receive new password again */
-		if (g_matchingFlag == 0)
-		{
-			recieveCheckNewPassword ();
-		}
-		/* When the new pass and confirmation are matched start the system options by receiving the user choice*/
-		else if (g_matchingFlag == 1)
-		{
-			getDefinedPassword ();
-		}
+		DOOR_dispatch (DOOR_EV_RESTORED);							/* Resume without a new password */
 	}
+	DOOR_recover ();												/* Finish a door cycle cut by a reset */
+	g_bootMs = (uint16)TIME_nowMs ();
+
+	linkByteReceived ();											/* For the bytes received during the start up */
+	SCHED_run ();													/* Never returns */
 }
 
 /*******************************************************************************
@@ -121,175 +122,156 @@ int main (void)
 
 /*
  * Description:
- * Timer1 first call back function after counting 15 seconds:
- * 1. First call stops the motor for 3 seconds after 15 seconds and initialize the timer for counting 3 seconds.
- * 2. Second call stops the motor after gate is closed and de-initialise the timer.
+ * ISR side call backs, they only post the matching event to the scheduler.
  */
-void timerCallBack_15Sec (void)
+void linkByteReceived (void)
 {
-	static uint8 counter = 0;
-	counter++;
-	switch (counter)
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
 	{
-	case 2:
-
-		DcMotor_stop ();						   /* Stop the motor after being unlocking for 15 seconds */
-		TIMER1_deInit ();
-		TIMER1_setCallBack (timerCallBack_3Sec);   /* Set the second call back */
-		TIMER1_init (&s_timerConfigurations_3Sec); /* Start to count 3 seconds for door to start locking again */
-		break;
-	case 4:
-		DcMotor_stop ();						   /* Stop the motor after being locked again */
-		TIMER1_deInit ();						   /* De_initialize the timer */
-		counter = 0;
+		if (g_linkRxPosted == FALSE)
+		{
+			g_linkRxPosted = SCHED_post (EVENT_LINK_RX, 0);
+		}
 	}
 }
 
-/*
- * Description:
- * Timer1 second call back function after counting 3 seconds:
- * 1. After being called initialize the timer for counting another 15 seconds for the door to start locking.
- */
-void timerCallBack_3Sec (void)
+void doorTimerExpired (void)
 {
-	DcMotor_rotate (CCW, 100);					/* rotate motor CCW after being stopped for 3 seconds */
-	TIMER1_deInit ();
-	TIMER1_init (&s_timerConfigurations_15Sec); /* Start to count 15 seconds for door to be locked again */
-	TIMER1_setCallBack (timerCallBack_15Sec);   /* Set the first call back */
+	SCHED_post (EVENT_DOOR_TIMER, 0);
+}
+
+void passwordSaved (void)
+{
+	SCHED_post (EVENT_PASSWORD_SAVED, 0);
 }
 
 /*
  * Description:
- * Timer1 third call back function after counting 1 minute:
- * 1. After being called stops the buzzer ringing which started when 3 consecutive passwords are wrong.
+ * Scheduler handlers, each one runs to completion without blocking and feeds the door lock state machine.
  */
-void timerCallBack_60Sec (void)
+void onDoorTimer (uint8 param)
+{
+	DOOR_timerExpired ();
+}
+
+/* The new password write ended */
+void onPasswordSaved (uint8 param)
 {
-	static uint8 counter = 0;
-	counter++;
-	/* Because it takes 8 ISR to count 1 minute */
-	if (counter == 8)
+	DOOR_dispatch (CRED_isValid () ? DOOR_EV_SAVED : DOOR_EV_SAVE_FAILED);
+	if (g_replyPending)
 	{
-		BUZZER_off ();							/* Stop the buzzer after 1 minute */
-		TIMER1_deInit ();						/* De_initialize the timer */
-		counter = 0;
+		g_reply = *LINK_getLastSent ();             /* The reply of the new password request */
+		g_replyPending = FALSE;
 	}
 }
 
-/*
- * Description:
- * 1. Receive the new password and its confirmation from HMI_ECU.
- * 2. Compare the 2 passwords.
- * 3. If matched, send the confirm byte to HMI_ECU and save the password in EEPROM.
- * 4. If not matched, send the wrong byte to HMI_ECU and repeat again.
- */
-void recieveCheckNewPassword (void)
+/* Handle one received frame */
+void onLinkRx (uint8 param)
 {
-	uint8 i = 0;
-	uint8 breaking = 5;
-
-	/* Receive the 2 passwords */
-	UART_receiveString (g_passArray);
-	UART_receiveString (g_repeatedPassArray);
+	const LINK_FrameType *frame;
 
-	/* Compare the 2 passwords */
-	while ((g_passArray[i] != '\0') && (g_repeatedPassArray[i] != '\0'))
+	g_linkRxPosted = FALSE;
+	frame = LINK_receiveFrame ();
+	if (frame != NULL_PTR)
 	{
-		if (g_passArray[i] != g_repeatedPassArray[i])
+		switch (frame -> type)
 		{
+		case LINK_MSG_NEW_PASSWORD:
+		case LINK_MSG_AUTHENTICATE:
+			handleRequest (frame);
+			break;
+
+		case LINK_MSG_HELLO:
+			g_hasRequest = FALSE;                       /* HMI_ECU restarted, so did its sequence */
+			sendStatus ();
+			break;
+
+		case LINK_MSG_PROFILE_REQUEST:
+			PROF_dump ();
+			IDLE_dump ();
 			break;
 		}
-		i++;
-		breaking--;
 	}
 
-	/* Success Case */
-	if (breaking == 0)
+	/* One frame per event, so the higher priority events run between the frames */
+	if (LINK_isDataPending ())
 	{
-		UART_sendByte (CONFIRM_BYTE);                                         /* Send confirm byte */
-		g_matchingFlag = 1;
-		for (i = 0; i < 5; i++)
-		{
-			EEPROM_writeByte ((uint16)(EEPROM_ADDRESS + i), g_passArray[i]);  /* Save password in EEPROM */
-			_delay_ms (10);
-		}
+		linkByteReceived ();
 	}
-	/* Fail Case */
-	else
+}
+
+void sendStatus (void)
+{
+	uint8 status [3];
+
+	switch (DOOR_getState ())
 	{
-		UART_sendByte (WRONG_BYTE);											  /* Send wrong byte */
+	case DOOR_STATE_SETUP:
+	case DOOR_STATE_SAVING:
+		status[0] = LINK_STATUS_SETUP;
+		break;
+
+	case DOOR_STATE_UNLOCKING:
+	case DOOR_STATE_HOLD:
+	case DOOR_STATE_LOCKING:
+		status[0] = LINK_STATUS_LOCKING;                    /* The cycle ends with the door locked */
+		break;
+
+	case DOOR_STATE_LOCKOUT:
+		status[0] = LINK_STATUS_LOCKOUT;
+		break;
+
+	default:
+		status[0] = LINK_STATUS_READY;
+		break;
 	}
+	status[1] = (uint8)(g_bootMs >> 8);
+	status[2] = (uint8)g_bootMs;
+	LINK_sendFrame (LINK_MSG_STATUS, status, 3);
 }
 
-/*
- * Description:
- * 1. Receive the user input password for selecting either open door or change pass from HMI_ECU.
- * 2. Compare it with the password saved in EEPROM.
- * 3. If matched, receive the user choice byte and if '+' rotate the motor, if '-' change password.
- * 4. If not matched, send repeat byte to HMI_ECU to ask for password 2 more times.
- * 5. If matched in the 2 next iterations take the action.
- * 6. If not matched in the 3 iterations, send wrong byte to HMI_ECU and start the buzzer.
- */
-void getDefinedPassword (void)
+void handleRequest (const LINK_FrameType *frame)
 {
-	uint8 i = 0;
-	uint8 breaking = 5;
-	uint8 recieved = 0;
-	static uint8 wrongIterations = 0;										  /* For counting the wrong pass */
+	const uint8 *request = &frame -> payload[LINK_REQUEST_SEQUENCE_OFFSET + 1];
+	uint8 length = frame -> length - (LINK_REQUEST_SEQUENCE_OFFSET + 1);
+	bool taken = FALSE;
 
-	UART_receiveString (g_definedPassArray);								  /* Receive the user input pass */
-
-	/* Receive the pass stored in EEPROM */
-	for (i = 0; i < 5; i++)
+	if (frame -> length <= LINK_REQUEST_SEQUENCE_OFFSET)
 	{
-		EEPROM_readByte ((uint16)(EEPROM_ADDRESS + i), g_repeatedPassArray + i);
-		_delay_ms (10);
+		sendStatus ();                                  /* No sequence, not a request of this HMI_ECU */
+		return;
 	}
-	g_repeatedPassArray[i] = '\0';
 
-	/* Start comparing the 2 passwords */
-	i = 0;
-	while ((g_definedPassArray[i] != '\0') && (g_repeatedPassArray[i] != '\0'))
+	if (g_hasRequest && (frame -> payload[LINK_REQUEST_SEQUENCE_OFFSET] == g_requestSequence))
 	{
-		if (g_definedPassArray[i] != g_repeatedPassArray[i])
+		/* Taken already, a pending reply is sent when the password write ends */
+		if (!g_replyPending)
 		{
-			break;
+			LINK_sendFrame (g_reply.type, g_reply.payload, g_reply.length);
 		}
-		i++;
-		breaking--;
+		return;
 	}
-	/* Success Case */
-	if (breaking == 0)
+	g_hasRequest = TRUE;
+	g_requestSequence = frame -> payload[LINK_REQUEST_SEQUENCE_OFFSET];
+
+	if (frame -> type == LINK_MSG_NEW_PASSWORD)
 	{
-		UART_sendByte (CONFIRM_BYTE);                                         /* Send confirm byte */
-		recieved = UART_recieveByte ();										  /* Receive the user choice */
-		wrongIterations = 0;
-		if (recieved == '+')												  /* If open the door */
-		{
-			DcMotor_rotate (CW, 100);										  /* Start rotating the motor CW */
-			TIMER1_setCallBack (timerCallBack_15Sec);
-			TIMER1_init (&s_timerConfigurations_15Sec);						  /* Rotate for 15 seconds */
-		}
-		else if (recieved == '-')											  /* If change pass */
-		{
-			g_matchingFlag = 0;												  /* For calling recieveCheckNewPassword */
-		}
+		taken = DOOR_newPasswordReceived (request, length);
 	}
-	/* Fail Case */
 	else
 	{
-		wrongIterations++;													  /* Increment wrong iterations */
-		if (wrongIterations == 3)											  /* If it reaches 3 */
-		{
-			UART_sendByte (WRONG_BYTE);										  /* Send wrong byte */
-			TIMER1_setCallBack (timerCallBack_60Sec);
-			TIMER1_init (&s_timerConfigurations_60Sec);						  /* Start counting 60 seconds */
-			BUZZER_on ();													  /* Start the buzzer */
-			wrongIterations = 0;											  /* Restart the wrong iterations again */
-		}
-		else
-		{
-			UART_sendByte (REPEAT_BYTE);									  /* If less than 3 send repeat */
-		}
+		taken = DOOR_authenticateReceived (request, length);
+	}
+
+	if (!taken)
+	{
+		sendStatus ();
+	}
+
+	/* A matching new password is answered after its write, every other request is answered now */
+	g_replyPending = taken && (frame -> type == LINK_MSG_NEW_PASSWORD) && (DOOR_getState () == DOOR_STATE_SAVING);
+	if (!g_replyPending)
+	{
+		g_reply = *LINK_getLastSent ();
 	}
 }
@@ -0,0 +1,175 @@
+/******************************************************************************
+ *
+ * Module: CREDENTIALS
+ *
+ * File Name: credentials.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the RAM cache of the password stored in the external EEPROM
+ *
+ *******************************************************************************/
+
+#include "credentials.h"
+#include "external_eeprom.h"
+#include "profiler.h"
+#include <util/crc16.h> /* For the CRC-16/XMODEM update step, the same as the link */
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+
+/* RAM copy of the EEPROM record, with its header and its CRC */
+static uint8 g_record [CRED_RECORD_SIZE];
+static bool g_valid = FALSE;
+
+/* Background write of g_record started by CRED_startUpdate */
+static EEPROM_RequestType g_writeRequest = {CRED_EEPROM_ADDRESS, g_record, CRED_RECORD_SIZE, TRUE, NULL_PTR, EEPROM_REQUEST_DONE, NULL_PTR};
+static void (*g_updateCallBack_Ptr)(void) = NULL_PTR;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Return the CRC of the record bytes before its CRC field */
+static uint16 CRED_crc (const uint8 *record);
+
+/* Return TRUE if the record has the current magic and version and its CRC is right */
+static bool CRED_isRecordValid (const uint8 *record);
+
+/* Build the record of the password in the cache */
+static void CRED_fillRecord (const uint8 *password);
+
+/* EEPROM call back of the background write, from the TWI ISR */
+static void CRED_writeDone (EEPROM_RequestType *request);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * 1. Load the password record from the EEPROM into RAM, called once after TWI_init.
+ * 2. Validate its magic, its version and its CRC.
+ * Return TRUE if a valid password is cached.
+ */
+bool CRED_init (void)
+{
+	PROF_BEGIN (PROF_CRED_LOAD);
+	g_valid = (EEPROM_readBlock (CRED_EEPROM_ADDRESS, g_record, CRED_RECORD_SIZE) == SUCCESS);
+	PROF_END (PROF_CRED_LOAD);
+	g_valid = g_valid && CRED_isRecordValid (g_record);
+	return g_valid;
+}
+
+/*
+ * Description:
+ * Return TRUE if a valid password is cached.
+ */
+bool CRED_isValid (void)
+{
+	return g_valid;
+}
+
+/*
+ * Description:
+ * Return TRUE if the entry has exactly CRED_PASSWORD_LENGTH keys and matches the cached password.
+ * Served from RAM, the EEPROM is not accessed.
+ */
+bool CRED_check (const uint8 *entry, uint8 length)
+{
+	uint8 i = 0;
+
+	if ((g_valid == FALSE) || (length != CRED_PASSWORD_LENGTH))
+	{
+		return FALSE;
+	}
+	for (i = 0; i < CRED_PASSWORD_LENGTH; i++)
+	{
+		if (entry[i] != g_record[CRED_PASSWORD_OFFSET + i])
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Description:
+ * Replace the cached password with the CRED_PASSWORD_LENGTH keys of password and write it
+ * through to the EEPROM in the background, a_ptr is called
+ * once it ends, from the TWI ISR (or directly if the password did not change).
+ * CRED_isValid tells then if the password is stored. Checks fail while the write is running.
+ * Return FALSE without calling a_ptr if a previous update is still running.
+ */
+bool CRED_startUpdate (const uint8 *password, void (*a_ptr)(void))
+{
+	if (g_writeRequest.status == EEPROM_REQUEST_PENDING)
+	{
+		return FALSE;
+	}
+
+	if (CRED_check (password, CRED_PASSWORD_LENGTH))
+	{
+		if (a_ptr != NULL_PTR)
+		{
+			(*a_ptr)();                                     /* Same password, nothing to write */
+		}
+		return TRUE;
+	}
+
+	g_valid = FALSE;                                        /* Until the EEPROM holds the new record */
+	CRED_fillRecord (password);
+	g_updateCallBack_Ptr = a_ptr;
+	g_writeRequest.callBack = CRED_writeDone;
+	PROF_BEGIN (PROF_CRED_SAVE);
+	EEPROM_submit (&g_writeRequest);
+	return TRUE;
+}
+
+static void CRED_fillRecord (const uint8 *password)
+{
+	uint8 i = 0;
+	uint16 crc = 0;
+
+	g_record[0] = (uint8)(CRED_MAGIC >> 8);
+	g_record[1] = (uint8)CRED_MAGIC;
+	g_record[2] = CRED_VERSION;
+	for (i = 0; i < CRED_PASSWORD_LENGTH; i++)
+	{
+		g_record[CRED_PASSWORD_OFFSET + i] = password[i];
+	}
+	crc = CRED_crc (g_record);
+	g_record[CRED_CRC_OFFSET] = (uint8)(crc >> 8);
+	g_record[CRED_CRC_OFFSET + 1] = (uint8)crc;
+}
+
+static void CRED_writeDone (EEPROM_RequestType *request)
+{
+	PROF_END (PROF_CRED_SAVE);
+	g_valid = (request -> status == EEPROM_REQUEST_DONE);
+	if (g_updateCallBack_Ptr != NULL_PTR)
+	{
+		(*g_updateCallBack_Ptr)();
+	}
+}
+
+static uint16 CRED_crc (const uint8 *record)
+{
+	uint8 i = 0;
+	uint16 crc = 0;
+
+	for (i = 0; i < CRED_CRC_OFFSET; i++)
+	{
+		crc = _crc_xmodem_update (crc, record[i]);
+	}
+	return crc;
+}
+
+static bool CRED_isRecordValid (const uint8 *record)
+{
+	uint16 crc = ((uint16)record[CRED_CRC_OFFSET] << 8) | record[CRED_CRC_OFFSET + 1];
+
+	return (record[0] == (uint8)(CRED_MAGIC >> 8)) && (record[1] == (uint8)CRED_MAGIC) &&
+		   (record[2] == CRED_VERSION) && (crc == CRED_crc (record));
+}
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ * Module: CREDENTIALS
+ *
+ * File Name: credentials.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the RAM cache of the password stored in the external EEPROM
+ *
+ *******************************************************************************/
+
+#ifndef CREDENTIALS_H_
+#define CREDENTIALS_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Number of keys in a valid password */
+#define CRED_PASSWORD_LENGTH                 5
+
+/*
+ * EEPROM record, multi-byte fields are big endian:
+ * | magic (2) | version | password keys | CRC-16/XMODEM of the previous bytes (2) |
+ * A record with another magic or version (an erased or an older one) is not valid.
+ */
+#define CRED_EEPROM_ADDRESS                  0
+#define CRED_MAGIC                           0xD00Cu
+#define CRED_VERSION                         1
+#define CRED_PASSWORD_OFFSET                 3
+#define CRED_CRC_OFFSET                      (CRED_PASSWORD_OFFSET + CRED_PASSWORD_LENGTH)
+#define CRED_RECORD_SIZE                     (CRED_CRC_OFFSET + 2)
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * 1. Load the password record from the EEPROM into RAM, called once after TWI_init.
+ * 2. Validate its magic, its version and its CRC.
+ * Return TRUE if a valid password is cached.
+ */
+bool CRED_init (void);
+
+/*
+ * Description:
+ * Return TRUE if a valid password is cached.
+ */
+bool CRED_isValid (void);
+
+/*
+ * Description:
+ * Return TRUE if the entry has exactly CRED_PASSWORD_LENGTH keys and matches the cached password.
+ * Served from RAM, the EEPROM is not accessed.
+ */
+bool CRED_check (const uint8 *entry, uint8 length);
+
+/*
+ * Description:
+ * Replace the cached password with the CRED_PASSWORD_LENGTH keys of password and write it
+ * through to the EEPROM in the background, a_ptr is called
+ * once it ends, from the TWI ISR (or directly if the password did not change).
+ * CRED_isValid tells then if the password is stored. Checks fail while the write is running.
+ * Return FALSE without calling a_ptr if a previous update is still running.
+ */
+bool CRED_startUpdate (const uint8 *password, void (*a_ptr)(void));
+
+#endif /* CREDENTIALS_H_ */
@@ -0,0 +1,553 @@
+/******************************************************************************
+ *
+ * Module: Door Lock
+ *
+ * File Name: door_lock.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the table driven state machine of the door lock
+ *
+ *******************************************************************************/
+
+#include "door_lock.h"
+#include "buzzer.h"
+#include "dc_motor.h"
+#include "link.h"
+#include "sw_timer.h"
+#include "uptime.h"
+#include "profiler.h"
+#include "journal.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* States kept in the journal, the others leave the door locked and keep the last record */
+#define DOOR_JOURNALED_STATES          ((1u << DOOR_STATE_IDLE) | (1u << DOOR_STATE_UNLOCKING) | (1u << DOOR_STATE_HOLD) | \
+										(1u << DOOR_STATE_LOCKING) | (1u << DOOR_STATE_LOCKOUT))
+
+/* States running the motor for a whole step, timed in checkpoint slices */
+#define DOOR_STEP_STATES               ((1u << DOOR_STATE_UNLOCKING) | (1u << DOOR_STATE_LOCKING))
+
+/* Length of the whole motor step of a step state */
+#define DOOR_STEP_MS(state)            (((state) == DOOR_STATE_UNLOCKING) ? DOOR_UNLOCKING_MS : DOOR_LOCKING_MS)
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/* Table entry, an event with a NULL_PTR action has no transition in the state */
+typedef struct
+{
+	uint8 next;                     /* DOOR_State */
+	void (*action)(void);
+} DOOR_TransitionType;
+
+/* The whole state of the controller */
+typedef struct
+{
+	DOOR_State state;
+	uint8 wrongAttempts;            /* Wrong passwords in a row */
+	const uint8 *password;          /* New password of the event being dispatched */
+	SWTIMER_TimerType timer;        /* Times the door cycle steps and the lockout */
+	uint16 stepDoneMs;              /* Time of the motor step passed at the end of the running slice */
+	uint8 progress;                 /* Checkpoints passed in the motor step, journaled with the state */
+	void (*timerCallBack)(void);
+	void (*savedCallBack)(void);
+#if DOOR_TRACE_ENABLE
+	DOOR_TraceType trace [DOOR_TRACE_SIZE];
+	uint8 traceHead;                /* Free running index of the next entry */
+#endif
+} DOOR_ContextType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Transition actions */
+static void DOOR_savePassword (void);
+static void DOOR_reject (void);
+static void DOOR_confirm (void);
+static void DOOR_unlock (void);
+static void DOOR_change (void);
+static void DOOR_repeat (void);
+static void DOOR_lockout (void);
+static void DOOR_hold (void);
+static void DOOR_lock (void);
+static void DOOR_locked (void);
+static void DOOR_endLockout (void);
+static void DOOR_restored (void);
+static void DOOR_resumeLockout (void);
+static void DOOR_resumeLock (void);
+static void DOOR_checkpoint (void);
+
+/*
+ * Time the motor step of the new state from doneMs of it, it is cut in slices
+ * ending on the checkpoints so the journaled progress always means the same time.
+ */
+static void DOOR_startStep (uint16 doneMs);
+
+/* Start the timer up to the next checkpoint or the end of the motor step */
+static void DOOR_nextSlice (void);
+
+/* Return TRUE if the current state has a transition on the event */
+static bool DOOR_hasTransition (DOOR_Event event);
+
+/* Return TRUE if the entry has exactly DOOR_PASSWORD_LENGTH keys and all of them match the reference */
+static bool DOOR_entriesMatch (const uint8 *entry, uint8 length, const uint8 *reference);
+
+#if DOOR_TRACE_ENABLE
+/* Record the transition in the trace ring, overwriting the oldest one */
+static void DOOR_trace (DOOR_State from, DOOR_Event event, DOOR_State to);
+#endif
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+static DOOR_ContextType g_door;
+
+/* Kept in flash, a state row is read with two pgm_read accesses per event */
+static const DOOR_TransitionType g_table [DOOR_STATES_COUNT][DOOR_EVENTS_COUNT] PROGMEM =
+{
+	[DOOR_STATE_SETUP] =
+	{
+		[DOOR_EV_PASSWORDS_MATCH]    = {DOOR_STATE_SAVING,         DOOR_savePassword},
+		[DOOR_EV_PASSWORDS_MISMATCH] = {DOOR_STATE_SETUP,          DOOR_reject},
+		[DOOR_EV_RESTORED]           = {DOOR_STATE_IDLE,           DOOR_restored},
+	},
+	[DOOR_STATE_SAVING] =
+	{
+		[DOOR_EV_SAVED]              = {DOOR_STATE_IDLE,           DOOR_confirm},
+		[DOOR_EV_SAVE_FAILED]        = {DOOR_STATE_SETUP,          DOOR_reject},
+	},
+	[DOOR_STATE_IDLE] =
+	{
+		[DOOR_EV_OPEN]               = {DOOR_STATE_UNLOCKING,      DOOR_unlock},
+		[DOOR_EV_CHANGE]             = {DOOR_STATE_SETUP,          DOOR_change},
+		[DOOR_EV_WRONG]              = {DOOR_STATE_AUTHENTICATING, DOOR_repeat},
+		[DOOR_EV_WRONG_LIMIT]        = {DOOR_STATE_LOCKOUT,        DOOR_lockout},
+		[DOOR_EV_RESUME_LOCK]        = {DOOR_STATE_LOCKING,        DOOR_resumeLock},
+		[DOOR_EV_RESUME_LOCKOUT]     = {DOOR_STATE_LOCKOUT,        DOOR_resumeLockout},
+	},
+	[DOOR_STATE_AUTHENTICATING] =
+	{
+		[DOOR_EV_OPEN]               = {DOOR_STATE_UNLOCKING,      DOOR_unlock},
+		[DOOR_EV_CHANGE]             = {DOOR_STATE_SETUP,          DOOR_change},
+		[DOOR_EV_WRONG]              = {DOOR_STATE_AUTHENTICATING, DOOR_repeat},
+		[DOOR_EV_WRONG_LIMIT]        = {DOOR_STATE_LOCKOUT,        DOOR_lockout},
+	},
+	[DOOR_STATE_UNLOCKING] =
+	{
+		[DOOR_EV_TIMEOUT]            = {DOOR_STATE_HOLD,           DOOR_hold},
+		[DOOR_EV_CHECKPOINT]         = {DOOR_STATE_UNLOCKING,      DOOR_checkpoint},
+	},
+	[DOOR_STATE_HOLD] =
+	{
+		[DOOR_EV_TIMEOUT]            = {DOOR_STATE_LOCKING,        DOOR_lock},
+	},
+	[DOOR_STATE_LOCKING] =
+	{
+		[DOOR_EV_TIMEOUT]            = {DOOR_STATE_IDLE,           DOOR_locked},
+		[DOOR_EV_CHECKPOINT]         = {DOOR_STATE_LOCKING,        DOOR_checkpoint},
+	},
+	[DOOR_STATE_LOCKOUT] =
+	{
+		[DOOR_EV_TIMEOUT]            = {DOOR_STATE_IDLE,           DOOR_endLockout},
+	},
+};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Start in the setup state, dispatch DOOR_EV_RESTORED once CRED_init found a stored password.
+ * timerCallBack is called from the Timer1 ISR when the state timer expires,
+ * savedCallBack from the TWI ISR when the new password write ends.
+ * Each of them must lead to DOOR_dispatch of the matching event out of the ISR.
+ */
+void DOOR_init (void (*timerCallBack)(void), void (*savedCallBack)(void))
+{
+	SWTIMER_stop (&g_door.timer);
+	g_door.state = DOOR_STATE_SETUP;
+	g_door.wrongAttempts = 0;
+	g_door.password = NULL_PTR;
+	g_door.stepDoneMs = 0;
+	g_door.progress = 0;
+	g_door.timerCallBack = timerCallBack;
+	g_door.savedCallBack = savedCallBack;
+#if DOOR_TRACE_ENABLE
+	g_door.traceHead = 0;
+#endif
+}
+
+/*
+ * Description:
+ * Read the phase journal once at boot, after CRED_init, and finish what a reset cut:
+ * a door cut while opening, open or locking is closed by the locking left, sized by
+ * the journaled checkpoints, and a lockout is served again.
+ * Takes a fixed number of EEPROM reads, see JRNL_init.
+ */
+void DOOR_recover (void)
+{
+	uint8 phase = DOOR_STATE_IDLE;
+	uint8 progress = 0;
+	uint32 openMs = 0;
+
+	if (!JRNL_init (&phase, &progress))
+	{
+		return;
+	}
+
+	/*
+	 * The uptime restarts from zero, the checkpoints tell how far the cut step went:
+	 * with k of them it ran from k up to k + 1 checkpoints, so the locking left is never
+	 * short and overruns on the closed end stop by at most DOOR_CHECKPOINT_MS.
+	 * Without an agreed password the events are dropped and the journal is kept for the next boot.
+	 */
+	switch (phase)
+	{
+	case DOOR_STATE_UNLOCKING:
+		/* Close only what was opened, at the locking speed */
+		openMs = ((uint32)progress + 1) * DOOR_CHECKPOINT_MS;
+		if (openMs > DOOR_UNLOCKING_MS)
+		{
+			openMs = DOOR_UNLOCKING_MS;
+		}
+		g_door.stepDoneMs = DOOR_LOCKING_MS - (uint16)((openMs * DOOR_LOCKING_MS) / DOOR_UNLOCKING_MS);
+		DOOR_dispatch (DOOR_EV_RESUME_LOCK);
+		break;
+
+	case DOOR_STATE_HOLD:
+		g_door.stepDoneMs = 0;                          /* Fully open, the whole locking step */
+		DOOR_dispatch (DOOR_EV_RESUME_LOCK);
+		break;
+
+	case DOOR_STATE_LOCKING:
+		/* Partly closed, never left ajar */
+		g_door.stepDoneMs = ((uint32)progress * DOOR_CHECKPOINT_MS < DOOR_LOCKING_MS) ?
+							(uint16)progress * DOOR_CHECKPOINT_MS : DOOR_LOCKING_MS - 1;
+		DOOR_dispatch (DOOR_EV_RESUME_LOCK);
+		break;
+
+	case DOOR_STATE_LOCKOUT:
+		DOOR_dispatch (DOOR_EV_RESUME_LOCKOUT);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+ * Description:
+ * Handle the expiry of the state timer, called out of the ISR: a checkpoint
+ * while a motor step has time left and DOOR_EV_TIMEOUT otherwise.
+ */
+void DOOR_timerExpired (void)
+{
+	if ((DOOR_STEP_STATES & (1u << g_door.state)) && (g_door.stepDoneMs < DOOR_STEP_MS (g_door.state)))
+	{
+		DOOR_dispatch (DOOR_EV_CHECKPOINT);
+	}
+	else
+	{
+		DOOR_dispatch (DOOR_EV_TIMEOUT);
+	}
+}
+
+/*
+ * Description:
+ * Take the transition of the current state on the event, O(1).
+ * The events without a transition in the current state are dropped.
+ * Return TRUE if the transition was taken.
+ */
+bool DOOR_dispatch (DOOR_Event event)
+{
+	DOOR_State from = g_door.state;
+	void (*action)(void);
+
+	if (event >= DOOR_EVENTS_COUNT)
+	{
+		return FALSE;
+	}
+
+	PROF_BEGIN (PROF_DOOR_DISPATCH);
+	action = (void (*)(void))pgm_read_ptr (&g_table[from][event].action);
+	if (action != NULL_PTR)
+	{
+		g_door.state = (DOOR_State)pgm_read_byte (&g_table[from][event].next);
+		(*action)();
+		if (DOOR_JOURNALED_STATES & (1u << g_door.state))
+		{
+			JRNL_record (g_door.state, g_door.progress);    /* Repeated records are not written again */
+		}
+#if DOOR_TRACE_ENABLE
+		DOOR_trace (from, event, g_door.state);
+#endif
+	}
+	PROF_END (PROF_DOOR_DISPATCH);
+	return (action != NULL_PTR) ? TRUE : FALSE;
+}
+
+/*
+ * Description:
+ * Return the current state.
+ */
+DOOR_State DOOR_getState (void)
+{
+	return g_door.state;
+}
+
+/*
+ * Description:
+ * Turn a new password frame payload (first entry length, first entry, confirmation entry)
+ * into its event and dispatch it.
+ * Return FALSE if the frame was not answered, it is empty or not expected in the current state.
+ */
+bool DOOR_newPasswordReceived (const uint8 *payload, uint8 length)
+{
+	bool matched = FALSE;
+	bool answered = FALSE;
+
+	if (length == 0)
+	{
+		return FALSE;
+	}
+
+	/* Both entries have DOOR_PASSWORD_LENGTH keys and they are identical */
+	matched = (length == 1 + (2 * DOOR_PASSWORD_LENGTH)) &&
+			  DOOR_entriesMatch (&payload[1], payload[0], &payload[1 + DOOR_PASSWORD_LENGTH]);
+
+	g_door.password = &payload[1];
+	answered = DOOR_dispatch (matched ? DOOR_EV_PASSWORDS_MATCH : DOOR_EV_PASSWORDS_MISMATCH);
+	g_door.password = NULL_PTR;
+	return answered;
+}
+
+/*
+ * Description:
+ * Turn an authenticate frame payload (action '+' or '-', password entry) into its event and dispatch it.
+ * Return FALSE if the frame was not answered, it is empty or not expected in the current state.
+ */
+bool DOOR_authenticateReceived (const uint8 *payload, uint8 length)
+{
+	bool matched = FALSE;
+
+	if (length == 0)
+	{
+		return FALSE;
+	}
+
+	/* Compared with the cached pass without accessing the EEPROM */
+	PROF_BEGIN (PROF_CRED_CHECK);
+	matched = CRED_check (&payload[1], length - 1);
+	PROF_END (PROF_CRED_CHECK);
+
+	if (matched)
+	{
+		if (payload[0] == '+')
+		{
+			return DOOR_dispatch (DOOR_EV_OPEN);
+		}
+		if (payload[0] == '-')
+		{
+			return DOOR_dispatch (DOOR_EV_CHANGE);
+		}
+		if (!DOOR_hasTransition (DOOR_EV_OPEN))
+		{
+			return FALSE;                                   /* Not waiting for a password, answered by the status */
+		}
+		LINK_sendFrame (LINK_MSG_REPEAT, NULL_PTR, 0);      /* Unknown action, not a wrong password */
+		return TRUE;
+	}
+	if (g_door.wrongAttempts + 1 >= DOOR_MAX_WRONG_ATTEMPTS)
+	{
+		return DOOR_dispatch (DOOR_EV_WRONG_LIMIT);
+	}
+	return DOOR_dispatch (DOOR_EV_WRONG);
+}
+
+#if DOOR_TRACE_ENABLE
+/*
+ * Description:
+ * Copy up to maxEntries of the last transitions to entries, the oldest first, and return their number.
+ */
+uint8 DOOR_readTrace (DOOR_TraceType *entries, uint8 maxEntries)
+{
+	uint8 i = 0;
+	uint8 count = (g_door.traceHead < DOOR_TRACE_SIZE) ? g_door.traceHead : DOOR_TRACE_SIZE;
+	uint8 first = 0;
+
+	if (count > maxEntries)
+	{
+		count = maxEntries;
+	}
+	first = g_door.traceHead - count;
+	for (i = 0; i < count; i++)
+	{
+		entries[i] = g_door.trace[(uint8)(first + i) & (DOOR_TRACE_SIZE - 1)];
+	}
+	return count;
+}
+
+static void DOOR_trace (DOOR_State from, DOOR_Event event, DOOR_State to)
+{
+	DOOR_TraceType *entry = &g_door.trace[g_door.traceHead & (DOOR_TRACE_SIZE - 1)];
+
+	entry -> timeMs = TIME_nowMs ();
+	entry -> from = from;
+	entry -> event = event;
+	entry -> to = to;
+	/* Saturate past 255 so the count of valid entries stays right, the index keeps wrapping with the mask */
+	g_door.traceHead = (g_door.traceHead == 0xFF) ? DOOR_TRACE_SIZE : g_door.traceHead + 1;
+}
+#endif
+
+/* Start writing the new password, the saved call back ends the saving state */
+static void DOOR_savePassword (void)
+{
+	if (!CRED_startUpdate (g_door.password, g_door.savedCallBack))
+	{
+		(*g_door.savedCallBack)();                  /* A write is still running, the password is not valid */
+	}
+}
+
+static void DOOR_reject (void)
+{
+	LINK_sendFrame (LINK_MSG_WRONG, NULL_PTR, 0);
+}
+
+static void DOOR_confirm (void)
+{
+	LINK_sendFrame (LINK_MSG_CONFIRM, NULL_PTR, 0);
+}
+
+/* Correct password with the open door choice, rotate the motor CW */
+static void DOOR_unlock (void)
+{
+	LINK_sendFrame (LINK_MSG_CONFIRM, NULL_PTR, 0);
+	g_door.wrongAttempts = 0;
+	DcMotor_rotate (CW, 100);
+	DOOR_startStep (0);
+}
+
+/* Correct password with the change password choice */
+static void DOOR_change (void)
+{
+	LINK_sendFrame (LINK_MSG_CONFIRM, NULL_PTR, 0);
+	g_door.wrongAttempts = 0;
+}
+
+/* Wrong password, ask HMI_ECU for another try */
+static void DOOR_repeat (void)
+{
+	g_door.wrongAttempts++;
+	LINK_sendFrame (LINK_MSG_REPEAT, NULL_PTR, 0);
+}
+
+/* Last wrong password, ring the buzzer */
+static void DOOR_lockout (void)
+{
+	LINK_sendFrame (LINK_MSG_WRONG, NULL_PTR, 0);
+	DOOR_resumeLockout ();
+}
+
+/* Ring the buzzer for a whole lockout, also after a reset cut the previous one */
+static void DOOR_resumeLockout (void)
+{
+	g_door.wrongAttempts = 0;
+	BUZZER_on ();
+	SWTIMER_start (&g_door.timer, DOOR_LOCKOUT_MS, SWTIMER_ONE_SHOT, g_door.timerCallBack);
+}
+
+/* Door unlocked, stop the motor while it is open */
+static void DOOR_hold (void)
+{
+	DcMotor_stop ();
+	g_door.progress = 0;
+	SWTIMER_start (&g_door.timer, DOOR_HOLD_MS, SWTIMER_ONE_SHOT, g_door.timerCallBack);
+}
+
+/* Rotate the motor CCW to close the door */
+static void DOOR_lock (void)
+{
+	DcMotor_rotate (CCW, 100);
+	DOOR_startStep (0);
+}
+
+/* Close a door cut by a reset, DOOR_recover set the part of the locking step already done */
+static void DOOR_resumeLock (void)
+{
+	DcMotor_rotate (CCW, 100);
+	DOOR_startStep (g_door.stepDoneMs);
+}
+
+/* Door locked again */
+static void DOOR_locked (void)
+{
+	DcMotor_stop ();
+	g_door.progress = 0;
+}
+
+/* One more checkpoint of the motor step, journaled by DOOR_dispatch */
+static void DOOR_checkpoint (void)
+{
+	g_door.progress++;
+	DOOR_nextSlice ();
+}
+
+static void DOOR_startStep (uint16 doneMs)
+{
+	g_door.stepDoneMs = doneMs;
+	g_door.progress = (uint8)(doneMs / DOOR_CHECKPOINT_MS);
+	DOOR_nextSlice ();
+}
+
+static void DOOR_nextSlice (void)
+{
+	uint16 sliceMs = DOOR_CHECKPOINT_MS - (g_door.stepDoneMs % DOOR_CHECKPOINT_MS);
+
+	if (sliceMs > DOOR_STEP_MS (g_door.state) - g_door.stepDoneMs)
+	{
+		sliceMs = DOOR_STEP_MS (g_door.state) - g_door.stepDoneMs;
+	}
+	g_door.stepDoneMs += sliceMs;
+	SWTIMER_start (&g_door.timer, sliceMs, SWTIMER_ONE_SHOT, g_door.timerCallBack);
+}
+
+static void DOOR_endLockout (void)
+{
+	BUZZER_off ();
+}
+
+/* Stored password found at boot, HMI_ECU learns it from the startup handshake */
+static void DOOR_restored (void)
+{
+	g_door.wrongAttempts = 0;
+}
+
+static bool DOOR_hasTransition (DOOR_Event event)
+{
+	return (pgm_read_ptr (&g_table[g_door.state][event].action) != NULL_PTR) ? TRUE : FALSE;
+}
+
+static bool DOOR_entriesMatch (const uint8 *entry, uint8 length, const uint8 *reference)
+{
+	uint8 i = 0;
+	bool matched = (length == DOOR_PASSWORD_LENGTH) ? TRUE : FALSE;
+
+	PROF_BEGIN (PROF_CHECK_PASSWORD);
+	for (i = 0; (matched == TRUE) && (i < DOOR_PASSWORD_LENGTH); i++)
+	{
+		if (entry[i] != reference[i])
+		{
+			matched = FALSE;
+		}
+	}
+	PROF_END (PROF_CHECK_PASSWORD);
+	return matched;
+}
@@ -0,0 +1,159 @@
+/******************************************************************************
+ *
+ * Module: Door Lock
+ *
+ * File Name: door_lock.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the table driven state machine of the door lock
+ *
+ *******************************************************************************/
+
+#ifndef DOOR_LOCK_H_
+#define DOOR_LOCK_H_
+
+#include "std_types.h"
+#include "credentials.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define DOOR_PASSWORD_LENGTH           CRED_PASSWORD_LENGTH   /* Number of keys in a valid password */
+#define DOOR_MAX_WRONG_ATTEMPTS        3                      /* Wrong passwords in a row before the lockout */
+#define DOOR_UNLOCKING_MS              15000                  /* Motor rotates CW to open the door */
+#define DOOR_HOLD_MS                   3000                   /* Door stays open */
+#define DOOR_LOCKING_MS                15000                  /* Motor rotates CCW to close the door */
+#define DOOR_LOCKOUT_MS                60000                  /* Buzzer rings after the wrong passwords */
+#define DOOR_CHECKPOINT_MS             3000                   /* Motor step progress journaled this often */
+
+#if (DOOR_CHECKPOINT_MS == 0 || (DOOR_UNLOCKING_MS / DOOR_CHECKPOINT_MS) > 255 || (DOOR_LOCKING_MS / DOOR_CHECKPOINT_MS) > 255)
+#error "A Motor Step Needs 1 To 255 Checkpoints"
+#endif
+
+/* Build with -DDOOR_TRACE_ENABLE=1 to record the transitions */
+#ifndef DOOR_TRACE_ENABLE
+#define DOOR_TRACE_ENABLE              0
+#endif
+
+/* Transitions kept by the trace, must be a power of two not greater than 128 */
+#define DOOR_TRACE_SIZE                16
+
+#if ((DOOR_TRACE_SIZE & (DOOR_TRACE_SIZE - 1)) != 0 || DOOR_TRACE_SIZE > 128)
+#error "The Door Trace Size Must Be A Power Of Two Not Greater Than 128"
+#endif
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	DOOR_STATE_SETUP,               /* No agreed password, waiting for a new one */
+	DOOR_STATE_SAVING,              /* The new password is being written to the EEPROM */
+	DOOR_STATE_IDLE,                /* Door locked, waiting for a request */
+	DOOR_STATE_AUTHENTICATING,      /* A wrong password was entered, waiting for another try */
+	DOOR_STATE_UNLOCKING,           /* Motor rotates CW */
+	DOOR_STATE_HOLD,                /* Door open */
+	DOOR_STATE_LOCKING,             /* Motor rotates CCW */
+	DOOR_STATE_LOCKOUT,             /* Buzzer rings after too many wrong passwords */
+	DOOR_STATES_COUNT
+} DOOR_State;
+
+typedef enum
+{
+	DOOR_EV_PASSWORDS_MATCH,        /* New password and its confirmation agree */
+	DOOR_EV_PASSWORDS_MISMATCH,
+	DOOR_EV_SAVED,                  /* The EEPROM holds the new password */
+	DOOR_EV_SAVE_FAILED,
+	DOOR_EV_OPEN,                   /* Correct password with the open door choice */
+	DOOR_EV_CHANGE,                 /* Correct password with the change password choice */
+	DOOR_EV_WRONG,                  /* Wrong password, tries left */
+	DOOR_EV_WRONG_LIMIT,            /* Wrong password, no tries left */
+	DOOR_EV_TIMEOUT,                /* The state timer expired */
+	DOOR_EV_CHECKPOINT,             /* A checkpoint of the running motor step passed */
+	DOOR_EV_RESTORED,               /* A valid password was loaded from the EEPROM at boot */
+	DOOR_EV_RESUME_LOCK,            /* The journal shows a door not locked before a reset */
+	DOOR_EV_RESUME_LOCKOUT,         /* The journal shows a lockout cut by a reset */
+	DOOR_EVENTS_COUNT
+} DOOR_Event;
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/* One taken transition */
+typedef struct
+{
+	uint32 timeMs;                  /* Uptime of the transition */
+	uint8 from;                     /* DOOR_State */
+	uint8 event;                    /* DOOR_Event */
+	uint8 to;                       /* DOOR_State */
+} DOOR_TraceType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Start in the setup state, dispatch DOOR_EV_RESTORED once CRED_init found a stored password.
+ * timerCallBack is called from the Timer1 ISR when the state timer expires,
+ * savedCallBack from the TWI ISR when the new password write ends.
+ * Each of them must lead to DOOR_dispatch of the matching event out of the ISR.
+ */
+void DOOR_init (void (*timerCallBack)(void), void (*savedCallBack)(void));
+
+/*
+ * Description:
+ * Read the phase journal once at boot, after CRED_init, and finish what a reset cut:
+ * a door cut while opening, open or locking is closed by the locking left, sized by
+ * the journaled checkpoints, and a lockout is served again.
+ * Takes a fixed number of EEPROM reads, see JRNL_init.
+ */
+void DOOR_recover (void);
+
+/*
+ * Description:
+ * Handle the expiry of the state timer, called out of the ISR: a checkpoint
+ * while a motor step has time left and DOOR_EV_TIMEOUT otherwise.
+ */
+void DOOR_timerExpired (void);
+
+/*
+ * Description:
+ * Take the transition of the current state on the event, O(1).
+ * The events without a transition in the current state are dropped.
+ * Return TRUE if the transition was taken.
+ */
+bool DOOR_dispatch (DOOR_Event event);
+
+/*
+ * Description:
+ * Return the current state.
+ */
+DOOR_State DOOR_getState (void);
+
+/*
+ * Description:
+ * Turn a new password frame payload (first entry length, first entry, confirmation entry)
+ * into its event and dispatch it.
+ * Return FALSE if the frame was not answered, it is empty or not expected in the current state.
+ */
+bool DOOR_newPasswordReceived (const uint8 *payload, uint8 length);
+
+/*
+ * Description:
+ * Turn an authenticate frame payload (action '+' or '-', password entry) into its event and dispatch it.
+ * Return FALSE if the frame was not answered, it is empty or not expected in the current state.
+ */
+bool DOOR_authenticateReceived (const uint8 *payload, uint8 length);
+
+#if DOOR_TRACE_ENABLE
+/*
+ * Description:
+ * Copy up to maxEntries of the last transitions to entries, the oldest first, and return their number.
+ */
+uint8 DOOR_readTrace (DOOR_TraceType *entries, uint8 maxEntries);
+#endif
+
+#endif /* DOOR_LOCK_H_ */
@@ -11,72 +11,216 @@
  *******************************************************************************/
 #include "external_eeprom.h"
 #include "i2c.h"
+#include <util/atomic.h>
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+
+/* Queue of the requests, the first one is running */
+static EEPROM_RequestType * volatile g_first = NULL_PTR;
+static EEPROM_RequestType * g_last = NULL_PTR;
+
+/* TWI transaction reused for every step of the running request */
+static TWI_TransactionType g_transaction;
+static uint16 g_offset = 0;         /* Bytes of the running request already transferred */
+static uint8 g_chunk = 0;           /* Bytes in the transaction on the bus */
+static bool g_polling = FALSE;      /* The transaction on the bus is an ACK poll */
+static uint16 g_polls = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Start the transaction of the next page (write) or read chunk of the running request */
+static void EEPROM_startChunk(void);
+
+/*
+ * Address the device without data, it does not acknowledge its address
+ * until the written page is committed.
+ */
+static void EEPROM_startPoll(void);
+
+/* TWI call back, move the running request to its next step */
+static void EEPROM_transactionDone(TWI_TransactionType * transaction);
+
+/* Complete the running request and start the next queued one */
+static void EEPROM_finish(EEPROM_RequestStatus status);
+
+/* Submit a request on the stack and wait for it */
+static uint8 EEPROM_transfer(uint16 u16addr, uint8 *buf, uint16 len, bool write);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+void EEPROM_submit(EEPROM_RequestType *request)
+{
+    request -> status = EEPROM_REQUEST_PENDING;
+    request -> next = NULL_PTR;
+
+    ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+    {
+        if (g_first == NULL_PTR)
+        {
+            g_first = request;
+            g_last = request;
+            g_offset = 0;
+            EEPROM_startChunk();
+        }
+        else
+        {
+            g_last -> next = request;
+            g_last = request;
+        }
+    }
+}
 
 uint8 EEPROM_writeByte(uint16 u16addr, uint8 u8data)
 {
-	/* Send the Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=0 (write) */
-    TWI_writeByte((uint8)(0xA0 | ((u16addr & 0x0700)>>7)));
-    if (TWI_getStatus() != TWI_MT_SLA_W_ACK)
-        return ERROR; 
-		 
-    /* Send the required memory location address */
-    TWI_writeByte((uint8)(u16addr));
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-		
-    /* write byte to eeprom */
-    TWI_writeByte(u8data);
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-
-    /* Send the Stop Bit */
-    TWI_stop();
-	
-    return SUCCESS;
+    return EEPROM_transfer(u16addr, &u8data, 1, TRUE);
 }
 
 uint8 EEPROM_readByte(uint16 u16addr, uint8 *u8data)
 {
-	/* Send the Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=0 (write) */
-    TWI_writeByte((uint8)((0xA0) | ((u16addr & 0x0700)>>7)));
-    if (TWI_getStatus() != TWI_MT_SLA_W_ACK)
-        return ERROR;
-		
-    /* Send the required memory location address */
-    TWI_writeByte((uint8)(u16addr));
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-		
-    /* Send the Repeated Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_REP_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=1 (Read) */
-    TWI_writeByte((uint8)((0xA0) | ((u16addr & 0x0700)>>7) | 1));
-    if (TWI_getStatus() != TWI_MT_SLA_R_ACK)
-        return ERROR;
-
-    /* Read Byte from Memory without send ACK */
-    *u8data = TWI_readByteWithNACK();
-    if (TWI_getStatus() != TWI_MR_DATA_NACK)
-        return ERROR;
-
-    /* Send the Stop Bit */
-    TWI_stop();
-
-    return SUCCESS;
+    return EEPROM_transfer(u16addr, u8data, 1, FALSE);
+}
+
+uint8 EEPROM_writeBlock(uint16 u16addr, const uint8 *buf, uint16 len)
+{
+    return EEPROM_transfer(u16addr, (uint8 *)buf, len, TRUE);
+}
+
+uint8 EEPROM_readBlock(uint16 u16addr, uint8 *buf, uint16 len)
+{
+    return EEPROM_transfer(u16addr, buf, len, FALSE);
+}
+
+static uint8 EEPROM_transfer(uint16 u16addr, uint8 *buf, uint16 len, bool write)
+{
+    EEPROM_RequestType request;
+
+    request.address = u16addr;
+    request.data = buf;
+    request.length = len;
+    request.write = write;
+    request.callBack = NULL_PTR;
+
+    EEPROM_submit(&request);
+    while (request.status == EEPROM_REQUEST_PENDING);
+
+    return (request.status == EEPROM_REQUEST_DONE) ? SUCCESS : ERROR;
+}
+
+static void EEPROM_startChunk(void)
+{
+    EEPROM_RequestType *request = g_first;
+    uint16 u16addr = request -> address + g_offset;
+    uint16 remaining = request -> length - g_offset;
+
+    if (remaining == 0)
+    {
+        EEPROM_finish(EEPROM_REQUEST_DONE);
+        return;
+    }
+
+    /* Write up to the end of the page, read up to the end of the aligned read chunk */
+    if (request -> write)
+        g_chunk = EEPROM_PAGE_SIZE - (u16addr % EEPROM_PAGE_SIZE);
+    else
+        g_chunk = EEPROM_READ_CHUNK_SIZE - (u16addr % EEPROM_READ_CHUNK_SIZE);
+    if (g_chunk > remaining)
+        g_chunk = (uint8)remaining;
+
+    /* A8 A9 A10 address bits are part of the device address, A0..A7 are the sub-address */
+    g_transaction.slaveAddress = (uint8)(EEPROM_DEVICE_ADDRESS | ((u16addr >> 8) & 0x07));
+    g_transaction.hasSubAddress = TRUE;
+    g_transaction.subAddress = (uint8)u16addr;
+    if (request -> write)
+    {
+        g_transaction.writeData = request -> data + g_offset;
+        g_transaction.writeLength = g_chunk;
+        g_transaction.readLength = 0;
+    }
+    else
+    {
+        g_transaction.writeLength = 0;
+        g_transaction.readData = request -> data + g_offset;
+        g_transaction.readLength = g_chunk;
+    }
+    g_transaction.callBack = EEPROM_transactionDone;
+    g_polling = FALSE;
+
+    if (!TWI_submit(&g_transaction))
+        EEPROM_finish(EEPROM_REQUEST_FAILED);
+}
+
+static void EEPROM_startPoll(void)
+{
+    g_transaction.hasSubAddress = FALSE;
+    g_transaction.writeLength = 0;
+    g_transaction.readLength = 0;
+    g_polling = TRUE;
+
+    if (!TWI_submit(&g_transaction))
+        EEPROM_finish(EEPROM_REQUEST_FAILED);
+}
+
+static void EEPROM_transactionDone(TWI_TransactionType * transaction)
+{
+    if (g_polling)
+    {
+        if (transaction -> status == TWI_TRANSACTION_DONE)
+        {
+            /* The page is committed */
+            EEPROM_startChunk();
+        }
+        else if ((transaction -> status == TWI_TRANSACTION_NACK) && (++g_polls < EEPROM_MAX_ACK_POLLS))
+        {
+            EEPROM_startPoll();
+        }
+        else
+        {
+            EEPROM_finish(EEPROM_REQUEST_FAILED);
+        }
+    }
+    else if (transaction -> status != TWI_TRANSACTION_DONE)
+    {
+        EEPROM_finish(EEPROM_REQUEST_FAILED);
+    }
+    else
+    {
+        g_offset += g_chunk;
+        if (g_first -> write)
+        {
+            /* The EEPROM starts its internal write cycle after the stop bit */
+            g_polls = 0;
+            EEPROM_startPoll();
+        }
+        else
+        {
+            EEPROM_startChunk();
+        }
+    }
+}
+
+static void EEPROM_finish(EEPROM_RequestStatus status)
+{
+    EEPROM_RequestType *request = g_first;
+    EEPROM_RequestType *next = request -> next;
+
+    g_first = next;
+    request -> status = status;
+
+    /* A request submitted by the call back to an empty queue is started by EEPROM_submit */
+    if (request -> callBack != NULL_PTR)
+    {
+        (*request -> callBack)(request);
+    }
+
+    if (next != NULL_PTR)
+    {
+        g_offset = 0;
+        EEPROM_startChunk();
+    }
 }
@@ -22,11 +22,65 @@
 #define ERROR 0
 #define SUCCESS 1
 
+/* 7-bit TWI address of the 24C16, A8 A9 A10 of the memory address are its 3 low bits */
+#define EEPROM_DEVICE_ADDRESS 0x50
+
+/* 24C16 write page, a page write wraps around inside the page so blocks are split on its boundaries */
+#define EEPROM_PAGE_SIZE 16
+
+/* Longest sequential read transaction, aligned reads of this size never cross a 256 bytes block */
+#define EEPROM_READ_CHUNK_SIZE 128
+
+/* Number of device address polls before giving up on the end of the internal write cycle (tWR) */
+#define EEPROM_MAX_ACK_POLLS 1000
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	EEPROM_REQUEST_PENDING, EEPROM_REQUEST_DONE, EEPROM_REQUEST_FAILED
+} EEPROM_RequestStatus;
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/*
+ * Asynchronous request owned by the caller and kept alive until it completes.
+ * A write request returns only after the EEPROM committed the last page.
+ */
+typedef struct EEPROM_Request
+{
+	uint16 address;
+	uint8 *data;
+	uint16 length;
+	bool write;                                     /* TRUE to write data, FALSE to read into it */
+	void (*callBack)(struct EEPROM_Request *);      /* Called from the TWI ISR on completion, may be NULL_PTR */
+	volatile EEPROM_RequestStatus status;           /* Completion flag */
+	struct EEPROM_Request *next;                    /* Used by the driver queue */
+} EEPROM_RequestType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
+/*
+ * Description :
+ * Queue the request, the TWI ISR runs it in the background split in pages
+ * (write) or sequential read chunks, polling the device ACK after each page write.
+ * Can be called from a request call back.
+ */
+void EEPROM_submit(EEPROM_RequestType *request);
+
+/*
+ * Description :
+ * Blocking wrappers, submit a request and wait for its completion flag.
+ * Return SUCCESS or ERROR. Must not be called from an ISR or a call back.
+ */
 uint8 EEPROM_writeByte(uint16 u16addr,uint8 u8data);
 uint8 EEPROM_readByte(uint16 u16addr,uint8 *u8data);
+uint8 EEPROM_writeBlock(uint16 u16addr, const uint8 *buf, uint16 len);
+uint8 EEPROM_readBlock(uint16 u16addr, uint8 *buf, uint16 len);
  
 #endif /* EXTERNAL_EEPROM_H_ */
@@ -14,6 +14,7 @@
 #define GPIO_H_
 
 #include "std_types.h"
+#include <avr/io.h>
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -37,6 +38,14 @@
 #define PIN6_ID                6
 #define PIN7_ID                7
 
+/*
+ * Registers of a port number, PORTA has the highest address and every next port is
+ * 3 addresses below it. With a constant port number the address is a constant too.
+ */
+#define GPIO_PORT_REG(port_num)    (*(&PORTA - (3 * (port_num))))
+#define GPIO_DDR_REG(port_num)     (*(&DDRA - (3 * (port_num))))
+#define GPIO_PIN_REG(port_num)     (*(&PINA - (3 * (port_num))))
+
 /*******************************************************************************
  *                               Enumerations                                  *
  *******************************************************************************/
@@ -101,4 +110,74 @@ void GPIO_writePort(uint8 port_num, uint8 value);
  */
 uint8 GPIO_readPort(uint8 port_num);
 
+/*******************************************************************************
+ *                          Inline Functions                                   *
+ *******************************************************************************/
+
+/*
+ * The inline versions skip the range checks and the port switch of the functions above,
+ * with constant port and pin numbers each of them compiles to a single sbi, cbi, sbic/sbis,
+ * out or in instruction. The port and pin numbers must be valid, use the functions
+ * above when they are only known at run time.
+ */
+
+/*
+ * Description :
+ * Inline version of GPIO_setupPinDirection.
+ */
+static inline __attribute__((always_inline)) void GPIO_setupPinDirectionFast(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType direction)
+{
+	if(direction == PIN_OUTPUT)
+	{
+		GPIO_DDR_REG(port_num) |= (uint8)(1 << pin_num);
+	}
+	else
+	{
+		GPIO_DDR_REG(port_num) &= (uint8)~(1 << pin_num);
+	}
+}
+
+/*
+ * Description :
+ * Inline version of GPIO_writePin, any non zero value writes Logic High.
+ */
+static inline __attribute__((always_inline)) void GPIO_writePinFast(uint8 port_num, uint8 pin_num, uint8 value)
+{
+	if(value != LOGIC_LOW)
+	{
+		GPIO_PORT_REG(port_num) |= (uint8)(1 << pin_num);
+	}
+	else
+	{
+		GPIO_PORT_REG(port_num) &= (uint8)~(1 << pin_num);
+	}
+}
+
+/*
+ * Description :
+ * Inline version of GPIO_readPin.
+ */
+static inline __attribute__((always_inline)) uint8 GPIO_readPinFast(uint8 port_num, uint8 pin_num)
+{
+	return (GPIO_PIN_REG(port_num) & (uint8)(1 << pin_num)) ? LOGIC_HIGH : LOGIC_LOW;
+}
+
+/*
+ * Description :
+ * Inline version of GPIO_writePort.
+ */
+static inline __attribute__((always_inline)) void GPIO_writePortFast(uint8 port_num, uint8 value)
+{
+	GPIO_PORT_REG(port_num) = value;
+}
+
+/*
+ * Description :
+ * Inline version of GPIO_readPort.
+ */
+static inline __attribute__((always_inline)) uint8 GPIO_readPortFast(uint8 port_num)
+{
+	return GPIO_PIN_REG(port_num);
+}
+
 #endif /* GPIO_H_ */
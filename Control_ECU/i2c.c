@@ -13,6 +13,104 @@
 #include "i2c.h"
 #include "common_macros.h"
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+
+/* Queue of the transactions, the head one is on the bus */
+static TWI_TransactionType * volatile g_queue[TWI_QUEUE_SIZE];
+static volatile uint8 g_queueHead = 0;
+static volatile uint8 g_queueTail = 0;
+
+/* Progress of the transaction on the bus */
+static uint8 g_writeIndex = 0;      /* Bytes sent after SLA+W, the sub-address included */
+static uint8 g_readIndex = 0;       /* Bytes received after SLA+R */
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Finish the head transaction with the given status and start the next one or release the bus */
+static void TWI_complete(TWI_TransactionStatus status);
+
+/* Send the next byte of the write phase or move to the read phase or finish */
+static void TWI_writeNext(TWI_TransactionType * transaction);
+
+/*******************************************************************************
+ *                                    ISR                                      *
+ *******************************************************************************/
+
+/* Each TWI bus event moves the head transaction one step */
+ISR (TWI_vect)
+{
+	TWI_TransactionType * transaction = g_queue[g_queueTail & (TWI_QUEUE_SIZE - 1)];
+
+	switch (TWI_getStatus())
+	{
+	case TWI_START:
+		g_writeIndex = 0;
+		g_readIndex = 0;
+		TWDR = (uint8)(transaction -> slaveAddress << 1);           /* SLA+W */
+		TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+		break;
+
+	case TWI_REP_START:
+		TWDR = (uint8)((transaction -> slaveAddress << 1) | 1);     /* SLA+R */
+		TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+		break;
+
+	case TWI_MT_SLA_W_ACK:
+	case TWI_MT_DATA_ACK:
+		TWI_writeNext(transaction);
+		break;
+
+	case TWI_MT_SLA_W_NACK:
+		TWI_complete(TWI_TRANSACTION_NACK);
+		break;
+
+	case TWI_MT_SLA_R_ACK:
+		/* ACK every byte except the last one */
+		if (transaction -> readLength > 1)
+		{
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWEA);
+		}
+		else
+		{
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+		}
+		break;
+
+	case TWI_MR_DATA_ACK:
+		transaction -> readData[g_readIndex] = TWDR;
+		g_readIndex++;
+		if (g_readIndex < (transaction -> readLength - 1))
+		{
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWEA);
+		}
+		else
+		{
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+		}
+		break;
+
+	case TWI_MR_DATA_NACK:
+		transaction -> readData[g_readIndex] = TWDR;
+		TWI_complete(TWI_TRANSACTION_DONE);
+		break;
+
+	default:
+		/* TWI_MT_DATA_NACK, TWI_MR_SLA_R_NACK, TWI_ARB_LOST or a bus error */
+		TWI_complete(TWI_TRANSACTION_ERROR);
+		break;
+	}
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
 
 void TWI_init(const TWI_ConfigType * Config_Ptr)
 {
@@ -27,73 +125,96 @@ void TWI_init(const TWI_ConfigType * Config_Ptr)
     TWCR = (1<<TWEN); /* enable TWI */
 }
 
-void TWI_start(void)
+uint8 TWI_getStatus(void)
 {
-    /* 
-	 * Clear the TWINT flag before sending the start bit TWINT=1
-	 * send the start bit by TWSTA=1
-	 * Enable TWI Module TWEN=1 
-	 */
-    TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
-    
-    /* Wait for TWINT flag set in TWCR Register (start bit is send successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
+    uint8 status;
+    /* masking to eliminate first 3 bits and get the last 5 bits (status bits) */
+    status = TWSR & 0xF8;
+    return status;
 }
 
-void TWI_stop(void)
+bool TWI_submit(TWI_TransactionType * transaction)
 {
-    /* 
-	 * Clear the TWINT flag before sending the stop bit TWINT=1
-	 * send the stop bit by TWSTO=1
-	 * Enable TWI Module TWEN=1 
-	 */
-    TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+	bool queued = FALSE;
+
+	transaction -> status = TWI_TRANSACTION_PENDING;
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		if ((uint8)(g_queueHead - g_queueTail) < TWI_QUEUE_SIZE)
+		{
+			g_queue[g_queueHead & (TWI_QUEUE_SIZE - 1)] = transaction;
+			g_queueHead++;
+			queued = TRUE;
+
+			/* The bus was idle, send the start bit once the last stop bit is out and let the ISR continue */
+			if ((uint8)(g_queueHead - g_queueTail) == 1)
+			{
+				while (BIT_IS_SET(TWCR,TWSTO));
+				TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE);
+			}
+		}
+	}
+	return queued;
 }
 
-void TWI_writeByte(uint8 data)
+bool TWI_isBusy(void)
 {
-    /* Put data On TWI data Register */
-    TWDR = data;
-    /* 
-	 * Clear the TWINT flag before sending the data TWINT=1
-	 * Enable TWI Module TWEN=1 
-	 */ 
-    TWCR = (1 << TWINT) | (1 << TWEN);
-    /* Wait for TWINT flag set in TWCR Register(data is send successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
+	return (g_queueHead != g_queueTail);
 }
 
-uint8 TWI_readByteWithACK(void)
+static void TWI_writeNext(TWI_TransactionType * transaction)
 {
-	/* 
-	 * Clear the TWINT flag before reading the data TWINT=1
-	 * Enable sending ACK after reading or receiving data TWEA=1
-	 * Enable TWI Module TWEN=1 
-	 */ 
-    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA);
-    /* Wait for TWINT flag set in TWCR Register (data received successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
-    /* Read Data */
-    return TWDR;
+	uint8 subAddressLength = transaction -> hasSubAddress ? 1 : 0;
+
+	if (g_writeIndex < subAddressLength)
+	{
+		TWDR = transaction -> subAddress;
+		g_writeIndex++;
+		TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+	}
+	else if (g_writeIndex < (subAddressLength + transaction -> writeLength))
+	{
+		TWDR = transaction -> writeData[g_writeIndex - subAddressLength];
+		g_writeIndex++;
+		TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+	}
+	else if (transaction -> readLength != 0)
+	{
+		/* Send the Repeated Start Bit for the read phase */
+		TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE);
+	}
+	else
+	{
+		TWI_complete(TWI_TRANSACTION_DONE);
+	}
 }
 
-uint8 TWI_readByteWithNACK(void)
+static void TWI_complete(TWI_TransactionStatus status)
 {
-	/* 
-	 * Clear the TWINT flag before reading the data TWINT=1
-	 * Enable TWI Module TWEN=1 
+	TWI_TransactionType * transaction = g_queue[g_queueTail & (TWI_QUEUE_SIZE - 1)];
+
+	transaction -> busStatus = TWI_getStatus();
+	transaction -> status = status;
+
+	/*
+	 * The call back may queue the next transaction, the finished one stays at the
+	 * queue tail meanwhile so TWI_submit does not start the bus by itself.
 	 */
-    TWCR = (1 << TWINT) | (1 << TWEN);
-    /* Wait for TWINT flag set in TWCR Register (data received successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
-    /* Read Data */
-    return TWDR;
-}
+	if (transaction -> callBack != NULL_PTR)
+	{
+		(*transaction -> callBack)(transaction);
+	}
+	g_queueTail++;
 
-uint8 TWI_getStatus(void)
-{
-    uint8 status;
-    /* masking to eliminate first 3 bits and get the last 5 bits (status bits) */
-    status = TWSR & 0xF8;
-    return status;
+	if (g_queueHead != g_queueTail)
+	{
+		/* Send the Stop Bit followed by the Start Bit of the next transaction */
+		TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE);
+	}
+	else
+	{
+		/* Send the Stop Bit, no TWINT follows so the ISR stays quiet */
+		TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+	}
 }
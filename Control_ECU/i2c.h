@@ -23,11 +23,29 @@
 #define TWI_START         0x08 /* start has been sent */
 #define TWI_REP_START     0x10 /* repeated start */
 #define TWI_MT_SLA_W_ACK  0x18 /* Master transmit ( slave address + Write request ) to slave + ACK received from slave. */
+#define TWI_MT_SLA_W_NACK 0x20 /* Master transmit ( slave address + Write request ) to slave + NACK received from slave. */
 #define TWI_MT_SLA_R_ACK  0x40 /* Master transmit ( slave address + Read request ) to slave + ACK received from slave. */
+#define TWI_MR_SLA_R_NACK 0x48 /* Master transmit ( slave address + Read request ) to slave + NACK received from slave. */
 #define TWI_MT_DATA_ACK   0x28 /* Master transmit data and ACK has been received from Slave. */
+#define TWI_MT_DATA_NACK  0x30 /* Master transmit data and NACK has been received from Slave. */
+#define TWI_ARB_LOST      0x38 /* Arbitration lost in slave address or data bytes. */
 #define TWI_MR_DATA_ACK   0x50 /* Master received data and send ACK to slave. */
 #define TWI_MR_DATA_NACK  0x58 /* Master received data but doesn't send ACK to slave. */
 
+/* Number of transactions that can wait for the bus, must be a power of two */
+#define TWI_QUEUE_SIZE    4
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	TWI_TRANSACTION_PENDING,   /* Queued or on the bus */
+	TWI_TRANSACTION_DONE,      /* All bytes are transferred */
+	TWI_TRANSACTION_NACK,      /* The slave did not acknowledge its address (busy or absent) */
+	TWI_TRANSACTION_ERROR      /* Any other unexpected bus status, saved in busStatus */
+} TWI_TransactionStatus;
+
 /*******************************************************************************
  *                     Structures And Unions                                   *
  *******************************************************************************/
@@ -37,16 +55,44 @@ typedef struct
 	uint16 bitRate; /* Frequency (SCL) in KHz */
 }TWI_ConfigType;
 
+/*
+ * Transaction descriptor owned by the caller and kept alive until it completes:
+ * START, SLA+W, the sub-address byte if any, writeLength bytes of writeData,
+ * then if readLength is not zero REPEATED START, SLA+R and readLength bytes into readData, STOP.
+ * Without sub-address, write and read bytes, the transaction only probes the slave address.
+ */
+typedef struct TWI_Transaction
+{
+	uint8 slaveAddress;                             /* 7-bit slave address */
+	bool hasSubAddress;
+	uint8 subAddress;                               /* Memory/register address sent before writeData */
+	const uint8 *writeData;
+	uint8 writeLength;
+	uint8 *readData;
+	uint8 readLength;
+	void (*callBack)(struct TWI_Transaction *);    /* Called from the TWI ISR on completion, may be NULL_PTR */
+	volatile TWI_TransactionStatus status;          /* Completion flag */
+	uint8 busStatus;                                /* TWI status that ended the transaction */
+}TWI_TransactionType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 void TWI_init(const TWI_ConfigType * Config_Ptr);
-void TWI_start(void);
-void TWI_stop(void);
-void TWI_writeByte(uint8 data);
-uint8 TWI_readByteWithACK(void);
-uint8 TWI_readByteWithNACK(void);
 uint8 TWI_getStatus(void);
 
+/*
+ * Description :
+ * Queue the transaction and start the bus if it is idle, the TWI ISR runs it in the background.
+ * Can be called from a transaction call back. Return FALSE if the queue is full.
+ */
+bool TWI_submit(TWI_TransactionType * transaction);
+
+/*
+ * Description :
+ * Return TRUE while a transaction is on the bus or queued.
+ */
+bool TWI_isBusy(void);
+
 
 #endif /* TWI_H_ */
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * Module: Idle
+ *
+ * File Name: idle.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the idle sleep manager
+ *
+ *******************************************************************************/
+
+#ifndef IDLE_H_
+#define IDLE_H_
+
+#include "std_types.h"
+#include "profiler.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Measure the idle time and the wake up latency, with the profiler by default */
+#ifndef IDLE_STATS_ENABLE
+#define IDLE_STATS_ENABLE                    PROF_ENABLE
+#endif
+
+/*
+ * Report payload, multi-byte fields are big endian:
+ * | idle per mille (2) | wake ups (2) | handled wake ups (2) | mean latency us (4) | max latency us (4) |
+ */
+#define IDLE_REPORT_LENGTH                   14
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/* Statistics since the last IDLE_dump, the times in Timer1 counts but the window in ticks */
+typedef struct
+{
+	uint32 windowStart;             /* Software timers tick count of the last reset */
+	uint32 idleTicks;               /* Time spent sleeping, with the waking ISRs, in whole ticks */
+	uint16 idleCounts;              /* The rest below one tick */
+	uint32 wakeUp;                  /* Uptime of the last wake up */
+	uint32 latencyMax;
+	uint32 latencyTotal;
+	uint16 wakeUps;
+	uint16 handled;                 /* Wake ups followed by a handled event */
+	bool waiting;                   /* Woken up, waiting for the first handled event */
+} IDLE_StatsType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Select the idle sleep mode, the CPU stops but the timers, the UART, the TWI and the
+ * external interrupts keep running and wake it up. Called after SWTIMER_init.
+ */
+void IDLE_init (void);
+
+/*
+ * Description:
+ * Called with the interrupts disabled once the caller found nothing to do. Sleep until
+ * an interrupt and return after its ISR with the interrupts enabled. An interrupt raised
+ * after the check can't be missed, the sleep instruction runs right after sei.
+ */
+void IDLE_sleep (void);
+
+#if IDLE_STATS_ENABLE
+
+/*
+ * Description:
+ * Mark the start of an event handler, the first one after a wake up ends its latency.
+ */
+void IDLE_eventHandled (void);
+
+/*
+ * Description:
+ * Send one LINK_MSG_IDLE_REPORT frame then restart the statistics.
+ */
+void IDLE_dump (void);
+
+#else
+
+#define IDLE_eventHandled()
+#define IDLE_dump()
+
+#endif /* IDLE_STATS_ENABLE */
+
+#endif /* IDLE_H_ */
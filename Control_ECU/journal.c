@@ -0,0 +1,170 @@
+/******************************************************************************
+ *
+ * Module: Journal
+ *
+ * File Name: journal.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the power fail safe phase journal in the external EEPROM
+ *
+ *******************************************************************************/
+
+#include "journal.h"
+#include <util/atomic.h>
+#include <util/crc16.h> /* Same CRC as the credentials record */
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+
+/* Record being written, left untouched until its write ends */
+static uint8 g_record [JRNL_RECORD_SIZE];
+static EEPROM_RequestType g_writeRequest = {JRNL_EEPROM_ADDRESS, g_record, JRNL_RECORD_SIZE, TRUE, NULL_PTR, EEPROM_REQUEST_DONE, NULL_PTR};
+
+static uint8 g_nextSlot = 0;
+static uint16 g_sequence = 0;                   /* Sequence of the next record */
+static bool g_ready = FALSE;                    /* The ring was scanned by JRNL_init */
+
+/* Last phase and progress passed to JRNL_record, written or waiting for the running write to end */
+static volatile uint8 g_lastPhase = 0;
+static volatile uint8 g_lastProgress = 0;
+static volatile bool g_hasLastPhase = FALSE;
+static volatile bool g_waiting = FALSE;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Return the CRC of the record bytes before its CRC field */
+static uint16 JRNL_crc (const uint8 *record);
+
+/* Fill g_record with the phase and progress and submit its write to the next slot */
+static void JRNL_startWrite (uint8 phase, uint8 progress);
+
+/* EEPROM call back of the record write, from the TWI ISR */
+static void JRNL_writeDone (EEPROM_RequestType *request);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Find the newest valid record, called once after TWI_init with the I-bit set.
+ * Reads one record per slot, so it takes a fixed JRNL_SLOTS short reads.
+ * Return TRUE and the recorded phase and progress, or FALSE if the journal is empty.
+ */
+bool JRNL_init (uint8 *phase, uint8 *progress)
+{
+	uint8 slot = 0;
+	uint8 newestSlot = JRNL_SLOTS - 1;
+	uint16 sequence = 0;
+	uint16 newestSequence = 0;
+	uint8 record [JRNL_RECORD_SIZE];
+	bool found = FALSE;
+
+	for (slot = 0; slot < JRNL_SLOTS; slot++)
+	{
+		if ((EEPROM_readBlock (JRNL_EEPROM_ADDRESS + (uint16)slot * EEPROM_PAGE_SIZE, record, JRNL_RECORD_SIZE) != SUCCESS) ||
+			(record[0] != JRNL_MAGIC) ||
+			(JRNL_crc (record) != (((uint16)record[JRNL_CRC_OFFSET] << 8) | record[JRNL_CRC_OFFSET + 1])))
+		{
+			continue;                                   /* Erased, torn or unreadable slot */
+		}
+
+		/* The sequences in the ring are never more than JRNL_SLOTS apart, so the difference orders them across the wrap around */
+		sequence = ((uint16)record[JRNL_SEQUENCE_OFFSET] << 8) | record[JRNL_SEQUENCE_OFFSET + 1];
+		if ((found == FALSE) || ((sint16)(sequence - newestSequence) > 0))
+		{
+			found = TRUE;
+			newestSlot = slot;
+			newestSequence = sequence;
+			*phase = record[JRNL_PHASE_OFFSET];
+			*progress = record[JRNL_PROGRESS_OFFSET];
+		}
+	}
+
+	/* Continue after the newest record, an empty journal starts from the first slot */
+	g_nextSlot = (newestSlot == JRNL_SLOTS - 1) ? 0 : newestSlot + 1;
+	g_sequence = found ? newestSequence + 1 : 0;
+	g_lastPhase = found ? *phase : 0;
+	g_lastProgress = found ? *progress : 0;
+	g_hasLastPhase = found;
+	g_waiting = FALSE;
+	g_ready = TRUE;
+	return found;
+}
+
+/*
+ * Description:
+ * Non-blocking, record the phase and its progress in the next slot of the ring in the background.
+ * Nothing is written if both are already the last ones recorded, and if a write
+ * is still running only the latest ones are written after it.
+ * Ignored before JRNL_init, the next slot is not known yet.
+ */
+void JRNL_record (uint8 phase, uint8 progress)
+{
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		if (g_ready && ((g_hasLastPhase == FALSE) || (phase != g_lastPhase) || (progress != g_lastProgress)))
+		{
+			g_lastPhase = phase;
+			g_lastProgress = progress;
+			g_hasLastPhase = TRUE;
+			if (g_writeRequest.status == EEPROM_REQUEST_PENDING)
+			{
+				g_waiting = TRUE;                       /* Written by the call back of the running write */
+			}
+			else
+			{
+				JRNL_startWrite (phase, progress);
+			}
+		}
+	}
+}
+
+static void JRNL_startWrite (uint8 phase, uint8 progress)
+{
+	uint16 crc = 0;
+
+	g_record[0] = JRNL_MAGIC;
+	g_record[JRNL_SEQUENCE_OFFSET] = (uint8)(g_sequence >> 8);
+	g_record[JRNL_SEQUENCE_OFFSET + 1] = (uint8)g_sequence;
+	g_record[JRNL_PHASE_OFFSET] = phase;
+	g_record[JRNL_PROGRESS_OFFSET] = progress;
+	crc = JRNL_crc (g_record);
+	g_record[JRNL_CRC_OFFSET] = (uint8)(crc >> 8);
+	g_record[JRNL_CRC_OFFSET + 1] = (uint8)crc;
+
+	g_writeRequest.address = JRNL_EEPROM_ADDRESS + (uint16)g_nextSlot * EEPROM_PAGE_SIZE;
+	g_writeRequest.callBack = JRNL_writeDone;
+	g_sequence++;
+	g_nextSlot = (g_nextSlot == JRNL_SLOTS - 1) ? 0 : g_nextSlot + 1;
+	EEPROM_submit (&g_writeRequest);
+}
+
+static void JRNL_writeDone (EEPROM_RequestType *request)
+{
+	if (g_waiting)
+	{
+		g_waiting = FALSE;
+		JRNL_startWrite (g_lastPhase, g_lastProgress);
+	}
+	else if (request -> status != EEPROM_REQUEST_DONE)
+	{
+		g_hasLastPhase = FALSE;                         /* Not in the EEPROM, let the same phase be recorded again */
+	}
+}
+
+static uint16 JRNL_crc (const uint8 *record)
+{
+	uint8 i = 0;
+	uint16 crc = 0;
+
+	for (i = 0; i < JRNL_CRC_OFFSET; i++)
+	{
+		crc = _crc_xmodem_update (crc, record[i]);
+	}
+	return crc;
+}
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ * Module: Journal
+ *
+ * File Name: journal.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the power fail safe phase journal in the external EEPROM
+ *
+ *******************************************************************************/
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include "std_types.h"
+#include "external_eeprom.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Ring of JRNL_SLOTS records, one per EEPROM page so every write is a single page
+ * write cycle and the wear is spread over all the pages of the ring.
+ * Record, multi-byte fields are big endian:
+ * | magic | sequence (2) | phase | progress | CRC-16/XMODEM of the previous bytes (2) |
+ * The progress counts the checkpoints passed in the phase, so a reset cut step can be sized.
+ * The newest record with a right magic and CRC holds the phase, a record torn by a
+ * power failure fails its CRC and the one before it is used instead.
+ */
+#define JRNL_EEPROM_ADDRESS                  0x0100
+#define JRNL_SLOTS                           16
+#define JRNL_MAGIC                           0xA5
+#define JRNL_SEQUENCE_OFFSET                 1
+#define JRNL_PHASE_OFFSET                    3
+#define JRNL_PROGRESS_OFFSET                 4
+#define JRNL_CRC_OFFSET                      5
+#define JRNL_RECORD_SIZE                     (JRNL_CRC_OFFSET + 2)
+
+#if ((JRNL_EEPROM_ADDRESS % EEPROM_PAGE_SIZE) != 0 || JRNL_RECORD_SIZE > EEPROM_PAGE_SIZE)
+#error "Every Journal Record Must Fit In Its Own EEPROM Page"
+#endif
+
+#if (JRNL_SLOTS < 2 || JRNL_SLOTS > 128)
+#error "The Journal Needs 2 To 128 Slots"
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Find the newest valid record, called once after TWI_init with the I-bit set.
+ * Reads one record per slot, so it takes a fixed JRNL_SLOTS short reads.
+ * Return TRUE and the recorded phase and progress, or FALSE if the journal is empty.
+ */
+bool JRNL_init (uint8 *phase, uint8 *progress);
+
+/*
+ * Description:
+ * Non-blocking, record the phase and its progress in the next slot of the ring in the background.
+ * Nothing is written if both are already the last ones recorded, and if a write
+ * is still running only the latest ones are written after it.
+ * Ignored before JRNL_init, the next slot is not known yet.
+ */
+void JRNL_record (uint8 phase, uint8 progress);
+
+#endif /* JOURNAL_H_ */
@@ -0,0 +1,281 @@
+ /******************************************************************************
+ *
+ * Module: LINK
+ *
+ * File Name: link.c
+ *
+ * Description: Source file for the framed link layer between HMI_ECU and Control_ECU
+ *
+ * Author: Mohamed Nasser
+ *
+ *******************************************************************************/
+
+#include "link.h"
+#include "uart.h"
+#include <util/crc16.h> /* For the CRC-16/CCITT update step */
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	WAIT_SYNC, WAIT_TYPE, WAIT_LENGTH, WAIT_PAYLOAD, WAIT_CRC_HIGH, WAIT_CRC_LOW
+} LINK_ParserState;
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+static LINK_FrameType g_frame;                 /* The parser writes the incoming frame here directly */
+static LINK_FrameType g_lastSent;              /* Copy of the last frame sent */
+static LINK_ParserState g_state = WAIT_SYNC;
+static uint8 g_index = 0;                      /* Next payload byte to fill */
+static uint16 g_crc = LINK_CRC_INITIAL_VALUE;  /* CRC calculated over the received bytes */
+static uint8 g_receivedCrcHigh = 0;
+
+/* Bytes received after the SYNC of the frame being parsed, parsed again if the frame is dropped */
+static uint8 g_tail [LINK_MAX_FRAME_TAIL];
+static uint8 g_tailCount = 0;
+
+/* Bytes of dropped frames waiting to be parsed again, before the UART ones */
+static uint8 g_replay [LINK_MAX_FRAME_TAIL];
+static uint8 g_replayHead = 0;
+static uint8 g_replayCount = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Advance the parser by one received byte and return TRUE when a correct frame is completed.
+ */
+static bool LINK_parseByte(uint8 data);
+
+/*
+ * Description :
+ * Take the next byte to parse, a replayed one first. Return FALSE if there is none.
+ */
+static bool LINK_nextByte(uint8 *data);
+
+/*
+ * Description :
+ * Drop the frame being parsed and queue its bytes after the SYNC to be parsed again,
+ * so a SYNC inside them starts the next frame.
+ */
+static void LINK_dropFrame(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Reset the frame parser, called once after UART_init.
+ */
+void LINK_init(void)
+{
+	g_state = WAIT_SYNC;
+	g_tailCount = 0;
+	g_replayCount = 0;
+}
+
+/*
+ * Description :
+ * Send one frame of the required type and payload through the UART.
+ */
+void LINK_sendFrame(uint8 type, const uint8 *payload, uint8 length)
+{
+	uint8 i = 0;
+	uint16 crc = LINK_CRC_INITIAL_VALUE;
+
+	g_lastSent.type = type;
+	g_lastSent.length = length;
+	crc = _crc_xmodem_update (crc, type);
+	crc = _crc_xmodem_update (crc, length);
+	for (i = 0; i < length; i++)
+	{
+		g_lastSent.payload[i] = payload[i];
+		crc = _crc_xmodem_update (crc, payload[i]);
+	}
+
+	UART_sendByte (LINK_SYNC_BYTE);
+	UART_sendByte (type);
+	UART_sendByte (length);
+	for (i = 0; i < length; i++)
+	{
+		UART_sendByte (payload[i]);
+	}
+	UART_sendByte ((uint8)(crc >> 8));
+	UART_sendByte ((uint8)crc);
+}
+
+/*
+ * Description :
+ * Return the last frame sent by LINK_sendFrame, kept to send it again.
+ */
+const LINK_FrameType * LINK_getLastSent(void)
+{
+	return &g_lastSent;
+}
+
+/*
+ * Description :
+ * Non-blocking receive:
+ * 1. Feed the bytes waiting in the UART RX buffer to the frame parser.
+ * 2. Return the frame once its CRC is correct, or NULL_PTR if no complete frame is received yet.
+ * The parser fills the returned frame in place, so it stays valid only until the next call.
+ */
+const LINK_FrameType * LINK_receiveFrame(void)
+{
+	uint8 data;
+
+	/* Stop at the end of a frame so the bytes of the next one stay in the UART buffer */
+	while (LINK_nextByte (&data))
+	{
+		if (LINK_parseByte (data))
+		{
+			return &g_frame;
+		}
+	}
+	return NULL_PTR;
+}
+
+/*
+ * Description :
+ * Return TRUE if received bytes wait for LINK_receiveFrame, in the UART or left by a dropped frame.
+ */
+bool LINK_isDataPending(void)
+{
+	return ((g_replayCount != 0) || (UART_available () != 0)) ? TRUE : FALSE;
+}
+
+/*
+ * Description :
+ * Wait until a correct frame is received and return it, corrupted frames are dropped silently.
+ */
+const LINK_FrameType * LINK_waitFrame(void)
+{
+	const LINK_FrameType *frame;
+
+	do
+	{
+		frame = LINK_receiveFrame ();
+	} while (frame == NULL_PTR);
+
+	return frame;
+}
+
+/*
+ * Description :
+ * Advance the parser by one received byte and return TRUE when a correct frame is completed.
+ * Any length above LINK_MAX_PAYLOAD or CRC mismatch drops the frame, see LINK_dropFrame.
+ */
+static bool LINK_parseByte(uint8 data)
+{
+	bool completed = FALSE;
+
+	if (g_state != WAIT_SYNC)
+	{
+		g_tail[g_tailCount] = data;                /* At most LINK_MAX_FRAME_TAIL bytes before the frame ends */
+		g_tailCount++;
+	}
+
+	switch (g_state)
+	{
+	case WAIT_SYNC:
+		if (data == LINK_SYNC_BYTE)
+		{
+			g_crc = LINK_CRC_INITIAL_VALUE;
+			g_tailCount = 0;
+			g_state = WAIT_TYPE;
+		}
+		break;
+
+	case WAIT_TYPE:
+		g_frame.type = data;
+		g_crc = _crc_xmodem_update (g_crc, data);
+		g_state = WAIT_LENGTH;
+		break;
+
+	case WAIT_LENGTH:
+		if (data > LINK_MAX_PAYLOAD)
+		{
+			LINK_dropFrame ();                     /* Can not be a correct frame */
+		}
+		else
+		{
+			g_frame.length = data;
+			g_index = 0;
+			g_crc = _crc_xmodem_update (g_crc, data);
+			g_state = (data == 0) ? WAIT_CRC_HIGH : WAIT_PAYLOAD;
+		}
+		break;
+
+	case WAIT_PAYLOAD:
+		g_frame.payload[g_index] = data;
+		g_index++;
+		g_crc = _crc_xmodem_update (g_crc, data);
+		if (g_index == g_frame.length)
+		{
+			g_state = WAIT_CRC_HIGH;
+		}
+		break;
+
+	case WAIT_CRC_HIGH:
+		g_receivedCrcHigh = data;
+		g_state = WAIT_CRC_LOW;
+		break;
+
+	case WAIT_CRC_LOW:
+		completed = (((uint16)g_receivedCrcHigh << 8) | data) == g_crc;
+		if (completed)
+		{
+			g_state = WAIT_SYNC;
+		}
+		else
+		{
+			LINK_dropFrame ();
+		}
+		break;
+	}
+	return completed;
+}
+
+static bool LINK_nextByte(uint8 *data)
+{
+	if (g_replayCount != 0)
+	{
+		*data = g_replay[g_replayHead];
+		g_replayHead++;
+		g_replayCount--;
+		return TRUE;
+	}
+	return (UART_read (data, 1) != 0) ? TRUE : FALSE;
+}
+
+static void LINK_dropFrame(void)
+{
+	uint8 i;
+
+	if (g_replayCount == 0)
+	{
+		for (i = 0; i < g_tailCount; i++)
+		{
+			g_replay[i] = g_tail[i];
+		}
+		g_replayHead = 0;
+		g_replayCount = g_tailCount;
+	}
+	else
+	{
+		/*
+		 * Replay is only filled by a drop, which restarts the frame, so the whole tail was
+		 * read from the replay right before its head: step back over it. The replay shrinks
+		 * by the SYNC byte on every drop, so parsing it again always ends.
+		 */
+		g_replayHead -= g_tailCount;
+		g_replayCount += g_tailCount;
+	}
+	g_tailCount = 0;
+	g_state = WAIT_SYNC;
+}
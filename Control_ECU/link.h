@@ -0,0 +1,128 @@
+ /******************************************************************************
+ *
+ * Module: LINK
+ *
+ * File Name: link.h
+ *
+ * Description: Header file for the framed link layer between HMI_ECU and Control_ECU
+ *
+ * Author: Mohamed Nasser
+ *
+ *******************************************************************************/
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Frame format on the UART:
+ * | SYNC | TYPE | LENGTH | PAYLOAD (LENGTH bytes) | CRC16 high | CRC16 low |
+ * The CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) covers TYPE, LENGTH and PAYLOAD.
+ */
+#define LINK_SYNC_BYTE                       0x7E
+#define LINK_CRC_INITIAL_VALUE               0xFFFF
+
+/* Longest payload accepted, a frame announcing more is dropped by the parser */
+#define LINK_MAX_PAYLOAD                     16
+
+/*
+ * First byte of every request payload, stepped once per new request and kept by its resends,
+ * so Control_ECU answers a resent request with its last reply instead of taking it again.
+ */
+#define LINK_REQUEST_SEQUENCE_OFFSET         0
+
+/* Bytes of the longest frame after its SYNC: TYPE, LENGTH, PAYLOAD and the 2 CRC bytes */
+#define LINK_MAX_FRAME_TAIL                  (LINK_MAX_PAYLOAD + 4)
+
+/*
+ * First byte of the status payload, the state HMI_ECU continues in. The status answers
+ * the hello and every request Control_ECU cannot take in its current state.
+ */
+#define LINK_STATUS_SETUP                    0        /* No agreed password */
+#define LINK_STATUS_READY                    1        /* Password agreed, door locked */
+#define LINK_STATUS_LOCKING                  2        /* A door cycle is running, also one cut by a reset */
+#define LINK_STATUS_LOCKOUT                  3        /* The buzzer rings, also for a lockout cut by a reset */
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	/* Requests from HMI_ECU to Control_ECU */
+	LINK_MSG_NEW_PASSWORD = 0x01,   /* payload: sequence, length of first entry, first entry, confirmation entry */
+	LINK_MSG_AUTHENTICATE,          /* payload: sequence, action ('+' open door or '-' change password), the password entry */
+	LINK_MSG_HELLO,                 /* Startup handshake, sent until the status arrives */
+
+	/* Replies from Control_ECU to HMI_ECU */
+	LINK_MSG_CONFIRM = 0x10,        /* The password is accepted, the requested action is taken */
+	LINK_MSG_WRONG,                 /* The password is rejected */
+	LINK_MSG_REPEAT,                /* The password is rejected, ask for it again */
+	LINK_MSG_STATUS,                /* payload: LINK_STATUS_xxx, Control_ECU boot time in ms (2, big endian) */
+
+	/* Diagnostics, served by both ECUs */
+	LINK_MSG_PROFILE_REQUEST = 0x20,/* Ask for the profiler table and the idle statistics */
+	LINK_MSG_PROFILE_REPORT,        /* payload: one profiler probe, see profiler.h */
+	LINK_MSG_IDLE_REPORT,           /* payload: the idle statistics, see idle.h, sent after the probes */
+	LINK_MSG_BOOT_REPORT            /* payload: HMI_ECU then Control_ECU boot time in ms (2 + 2, big endian), 1 if over the budget */
+} LINK_MessageType;
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint8 type;
+	uint8 length;
+	uint8 payload [LINK_MAX_PAYLOAD];
+} LINK_FrameType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Reset the frame parser, called once after UART_init.
+ */
+void LINK_init(void);
+
+/*
+ * Description :
+ * Send one frame of the required type and payload through the UART.
+ */
+void LINK_sendFrame(uint8 type, const uint8 *payload, uint8 length);
+
+/*
+ * Description :
+ * Return the last frame sent by LINK_sendFrame, kept to send it again.
+ */
+const LINK_FrameType * LINK_getLastSent(void);
+
+/*
+ * Description :
+ * Non-blocking receive:
+ * 1. Feed the bytes waiting in the UART RX buffer to the frame parser.
+ * 2. Return the frame once its CRC is correct, or NULL_PTR if no complete frame is received yet.
+ * The parser fills the returned frame in place, so it stays valid only until the next call.
+ * The bytes of a dropped frame are parsed again after its SYNC, a frame starting inside it is not lost.
+ */
+const LINK_FrameType * LINK_receiveFrame(void);
+
+/*
+ * Description :
+ * Return TRUE if received bytes wait for LINK_receiveFrame, in the UART or left by a dropped frame.
+ */
+bool LINK_isDataPending(void);
+
+/*
+ * Description :
+ * Wait until a correct frame is received and return it, corrupted frames are dropped silently.
+ */
+const LINK_FrameType * LINK_waitFrame(void);
+
+#endif /* LINK_H_ */
@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ * Module: Profiler
+ *
+ * File Name: profiler.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the hot path profiler on the uptime clock
+ *
+ *******************************************************************************/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "std_types.h"
+#include "uptime.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Build with -DPROF_ENABLE=1 to profile, otherwise the probes are compiled out */
+#ifndef PROF_ENABLE
+#define PROF_ENABLE                          0
+#endif
+
+/* CPU cycles per Timer1 count, the resolution of the measurements */
+#define PROF_CYCLES_PER_TICK                 ((uint32)TIMER1_CFG_DIVIDER (SWTIMER_TICK_MS))
+
+/*
+ * Report payload, multi-byte fields are big endian:
+ * | probe id | calls (2) | min cycles (4) | max cycles (4) | mean cycles (4) |
+ */
+#define PROF_REPORT_LENGTH                   15
+
+/*
+ * The dump is triggered by LINK_MSG_PROFILE_REQUEST. Holding UI_PROFILE_KEY on the main menu of
+ * HMI_ECU sends it to control_ECU and dumps HMI_ECU too. The reports of both ECUs are not
+ * decoded by the other one, read them with a UART monitor on the line between the ECUs.
+ */
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	PROF_CRED_LOAD,                 /* CRED_init, read the password record on the TWI at boot */
+	PROF_CRED_SAVE,                 /* CRED_startUpdate up to the end of its background write, ends in the TWI ISR */
+	PROF_CRED_CHECK,                /* CRED_check, compare with the cached password */
+	PROF_CHECK_PASSWORD,            /* Compare the new password with its confirmation */
+	PROF_DOOR_DISPATCH,             /* DOOR_dispatch, one event of the door lock state machine */
+	PROF_PROBES_COUNT
+} PROF_ProbeId;
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/* Statistics of one probe in Timer1 counts */
+typedef struct
+{
+	uint32 start;                   /* Uptime at PROF_BEGIN */
+	uint32 min;
+	uint32 max;
+	uint32 total;                   /* Sum of all the calls for the mean */
+	uint16 count;                   /* Calls measured, stops at 65535 */
+} PROF_ProbeType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+#if PROF_ENABLE
+
+/*
+ * Description:
+ * Mark the start and the end of a measured section, a probe must not be nested in itself
+ * or used from the main loop and an ISR at the same time.
+ */
+#define PROF_BEGIN(id)                       PROF_begin (id)
+#define PROF_END(id)                         PROF_end (id)
+
+/*
+ * Description:
+ * Clear the table and measure the cost of an empty probe, which is removed from every measurement.
+ * Called after SWTIMER_init.
+ */
+void PROF_init (void);
+
+void PROF_begin (PROF_ProbeId id);
+void PROF_end (PROF_ProbeId id);
+
+/*
+ * Description:
+ * Send one LINK_MSG_PROFILE_REPORT frame for every probe, then clear the table.
+ */
+void PROF_dump (void);
+
+#else
+
+#define PROF_BEGIN(id)
+#define PROF_END(id)
+#define PROF_init()
+#define PROF_dump()
+
+#endif /* PROF_ENABLE */
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,198 @@
+/******************************************************************************
+ *
+ * Module: Scheduler
+ *
+ * File Name: scheduler.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the run to completion event scheduler
+ *
+ *******************************************************************************/
+
+#include "scheduler.h"
+#include "idle.h"
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint8 id;
+	uint8 param;
+} SCHED_EventType;
+
+typedef struct
+{
+	void (*handler)(uint8 param);
+	SCHED_Priority priority;
+} SCHED_HandlerType;
+
+/* Ring of events with free running indices, posted from ISRs so written inside atomic blocks */
+typedef struct
+{
+	SCHED_EventType events [SCHED_QUEUE_SIZE];
+	uint8 head;
+	uint8 tail;
+} SCHED_QueueType;
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+static SCHED_HandlerType g_handlers [SCHED_MAX_EVENTS];
+static volatile SCHED_QueueType g_queues [SCHED_PRIORITIES_COUNT];
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Return TRUE if any queue holds an event, called with the interrupts disabled */
+static bool SCHED_isPending (void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Empty the event queues and remove all the handlers.
+ */
+void SCHED_init (void)
+{
+	uint8 i = 0;
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		for (i = 0; i < SCHED_PRIORITIES_COUNT; i++)
+		{
+			g_queues[i].head = 0;
+			g_queues[i].tail = 0;
+		}
+		for (i = 0; i < SCHED_MAX_EVENTS; i++)
+		{
+			g_handlers[i].handler = NULL_PTR;
+		}
+	}
+}
+
+/*
+ * Description:
+ * Set the handler of the event and the priority its events are queued with.
+ * Return FALSE if the event id is out of range.
+ */
+bool SCHED_register (uint8 eventId, SCHED_Priority priority, void (*a_ptr)(uint8 param))
+{
+	if ((eventId >= SCHED_MAX_EVENTS) || (priority >= SCHED_PRIORITIES_COUNT))
+	{
+		return FALSE;
+	}
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		g_handlers[eventId].handler = a_ptr;
+		g_handlers[eventId].priority = priority;
+	}
+	return TRUE;
+}
+
+/*
+ * Description:
+ * Queue the event with its parameter, can be called from any ISR or call back.
+ * Return FALSE if the event has no handler or its priority queue is full.
+ */
+bool SCHED_post (uint8 eventId, uint8 param)
+{
+	bool queued = FALSE;
+	volatile SCHED_QueueType *queue;
+
+	if ((eventId >= SCHED_MAX_EVENTS) || (g_handlers[eventId].handler == NULL_PTR))
+	{
+		return FALSE;
+	}
+
+	queue = &g_queues[g_handlers[eventId].priority];
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		if ((uint8)(queue -> head - queue -> tail) < SCHED_QUEUE_SIZE)
+		{
+			queue -> events[queue -> head & (SCHED_QUEUE_SIZE - 1)].id = eventId;
+			queue -> events[queue -> head & (SCHED_QUEUE_SIZE - 1)].param = param;
+			queue -> head++;
+			queued = TRUE;
+		}
+	}
+	return queued;
+}
+
+/*
+ * Description:
+ * Run the handler of the oldest event of the highest priority to completion.
+ * Return FALSE if no event is waiting.
+ */
+bool SCHED_dispatch (void)
+{
+	uint8 i = 0;
+	bool found = FALSE;
+	SCHED_EventType event = {0, 0};
+	volatile SCHED_QueueType *queue;
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		for (i = 0; (i < SCHED_PRIORITIES_COUNT) && (found == FALSE); i++)
+		{
+			queue = &g_queues[i];
+			if (queue -> head != queue -> tail)
+			{
+				event.id = queue -> events[queue -> tail & (SCHED_QUEUE_SIZE - 1)].id;
+				event.param = queue -> events[queue -> tail & (SCHED_QUEUE_SIZE - 1)].param;
+				queue -> tail++;
+				found = TRUE;
+			}
+		}
+	}
+
+	/* The handler runs with the interrupts enabled so the ISRs keep posting meanwhile */
+	if (found && (g_handlers[event.id].handler != NULL_PTR))
+	{
+		IDLE_eventHandled ();
+		(*g_handlers[event.id].handler)(event.param);
+	}
+	return found;
+}
+
+/*
+ * Description:
+ * Dispatch the events for ever, the handlers must not block so any event waits
+ * at most for the handler running when it is posted and the events queued before it.
+ * The CPU sleeps while no event is waiting, every event is posted by an ISR which wakes it up.
+ */
+void SCHED_run (void)
+{
+	for(;;)
+	{
+		if (!SCHED_dispatch ())
+		{
+			cli ();
+			if (!SCHED_isPending ())
+			{
+				IDLE_sleep ();
+			}
+			sei ();
+		}
+	}
+}
+
+static bool SCHED_isPending (void)
+{
+	uint8 i = 0;
+
+	for (i = 0; i < SCHED_PRIORITIES_COUNT; i++)
+	{
+		if (g_queues[i].head != g_queues[i].tail)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
@@ -0,0 +1,79 @@
+/******************************************************************************
+ *
+ * Module: Scheduler
+ *
+ * File Name: scheduler.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the run to completion event scheduler
+ *
+ *******************************************************************************/
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Number of event ids, the ids are 0 .. SCHED_MAX_EVENTS - 1 */
+#define SCHED_MAX_EVENTS                     8
+
+/* Events waiting per priority, must be a power of two not greater than 128 */
+#define SCHED_QUEUE_SIZE                     8
+
+#if ((SCHED_QUEUE_SIZE & (SCHED_QUEUE_SIZE - 1)) != 0 || SCHED_QUEUE_SIZE > 128)
+#error "The Scheduler Queue Size Must Be A Power Of Two Not Greater Than 128"
+#endif
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	SCHED_PRIORITY_HIGH, SCHED_PRIORITY_NORMAL, SCHED_PRIORITY_LOW, SCHED_PRIORITIES_COUNT
+} SCHED_Priority;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Empty the event queues and remove all the handlers.
+ */
+void SCHED_init (void);
+
+/*
+ * Description:
+ * Set the handler of the event and the priority its events are queued with.
+ * Return FALSE if the event id is out of range.
+ */
+bool SCHED_register (uint8 eventId, SCHED_Priority priority, void (*a_ptr)(uint8 param));
+
+/*
+ * Description:
+ * Queue the event with its parameter, can be called from any ISR or call back.
+ * Return FALSE if the event has no handler or its priority queue is full.
+ */
+bool SCHED_post (uint8 eventId, uint8 param);
+
+/*
+ * Description:
+ * Run the handler of the oldest event of the highest priority to completion.
+ * Return FALSE if no event is waiting.
+ */
+bool SCHED_dispatch (void);
+
+/*
+ * Description:
+ * Dispatch the events for ever, the handlers must not block so any event waits
+ * at most for the handler running when it is posted and the events queued before it.
+ * The CPU sleeps while no event is waiting, every event is posted by an ISR which wakes it up.
+ */
+void SCHED_run (void);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,105 @@
+/******************************************************************************
+ *
+ * Module: Software Timers
+ *
+ * File Name: sw_timer.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the software timers multiplexed on the Timer1 tick
+ *
+ *******************************************************************************/
+
+#ifndef SW_TIMER_H_
+#define SW_TIMER_H_
+
+#include "std_types.h"
+#include "timer1_cfg.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Period of the Timer1 tick driving all the software timers */
+#define SWTIMER_TICK_MS                      10
+
+#if (!TIMER1_CFG_IS_REACHABLE (SWTIMER_TICK_MS) || TIMER1_CFG_ISR_COUNT (SWTIMER_TICK_MS) != 1)
+#error "The Software Timers Tick Must Be One Timer1 Compare Period"
+#endif
+
+/* Number of slots in the timing wheel, must be a power of two */
+#define SWTIMER_WHEEL_SIZE                   16
+
+#if ((SWTIMER_WHEEL_SIZE & (SWTIMER_WHEEL_SIZE - 1)) != 0)
+#error "The Timing Wheel Size Must Be A Power Of Two"
+#endif
+
+/* Longest timeout, the ticks are counted in 16 bits */
+#define SWTIMER_MAX_TIMEOUT_MS               (65535UL * SWTIMER_TICK_MS)
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	SWTIMER_ONE_SHOT, SWTIMER_PERIODIC
+} SWTIMER_Mode;
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/* Node of the circular lists hanging from the wheel slots */
+typedef struct SWTIMER_Link
+{
+	struct SWTIMER_Link *next;
+	struct SWTIMER_Link *prev;
+} SWTIMER_LinkType;
+
+/* Software timer owned by the caller, static or zeroed before first use, its fields are private to the driver */
+typedef struct
+{
+	SWTIMER_LinkType link;              /* Must be the first member */
+	uint16 rounds;                      /* Wheel turns left before expiring */
+	uint16 periodTicks;                 /* Zero for a one shot timer */
+	void (*callBack)(void);
+} SWTIMER_TimerType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * 1. Empty the timing wheel.
+ * 2. Start Timer1 in compare mode with a SWTIMER_TICK_MS interrupt.
+ */
+void SWTIMER_init (void);
+
+/*
+ * Description:
+ * Arm the timer to call a_ptr after timeoutMs (rounded up to the tick), then every timeoutMs
+ * if the mode is periodic. Restart it if it is already armed. O(1).
+ * The call back runs from the Timer1 ISR and may start or stop any timer.
+ */
+void SWTIMER_start (SWTIMER_TimerType *timer, uint32 timeoutMs, SWTIMER_Mode mode, void (*a_ptr)(void));
+
+/*
+ * Description:
+ * Cancel the timer if it is armed. O(1).
+ */
+void SWTIMER_stop (SWTIMER_TimerType *timer);
+
+/*
+ * Description:
+ * Return TRUE if the timer is armed.
+ */
+bool SWTIMER_isActive (const SWTIMER_TimerType *timer);
+
+/*
+ * Description:
+ * Return the number of ticks since SWTIMER_init, wraps around after 2^32 ticks.
+ */
+uint32 SWTIMER_getTickCount (void);
+
+#endif /* SW_TIMER_H_ */
@@ -16,6 +16,7 @@
 #define TIMER1_H_
 
 #include "std_types.h"
+#include "timer1_cfg.h"
 
 /*******************************************************************************
  *                               Enumerations                                  *
@@ -33,11 +34,13 @@ typedef enum
 /*******************************************************************************
  *                     Structures And Unions                                   *
  *******************************************************************************/
+/* Use TIMER1_CONFIG(ms) from timer1_cfg.h to derive it from a duration */
 typedef struct {
 uint16 initial_value;
 uint16 compare_value; // it will be used in compare mode only.
 TIMER1_Prescaler prescaler;
 TIMER1_Mode mode;
+uint8 isr_count; // interrupts per call back, 0 is the same as 1.
 } TIMER1_ConfigType;
 
 /*******************************************************************************
@@ -51,6 +54,7 @@ TIMER1_Mode mode;
  * 2. Set the compare value if needed.
  * 3. Select the required pre-scaler.
  * 4. Select the timer mode.
+ * 5. Set the number of interrupts per call back.
  */
 void TIMER1_init(const TIMER1_ConfigType * Config_Ptr);
 
@@ -66,4 +70,16 @@ void TIMER1_setCallBack(void(*a_ptr)(void));
  */
 void TIMER1_deInit(void);
 
+/*
+ * Description:
+ * Function to read the Timer1 counter.
+ */
+uint16 TIMER1_getCount(void);
+
+/*
+ * Description:
+ * Function to check if the interrupt of the running mode is raised but not served yet.
+ */
+bool TIMER1_isInterruptPending(void);
+
 #endif /* TIMER1_H_ */
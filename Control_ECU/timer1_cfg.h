@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ * Module: Timer 1
+ *
+ * File Name: timer1_cfg.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Compile time generator of the timer 1 configurations from a duration in ms and F_CPU
+ *
+ *******************************************************************************/
+
+#ifndef TIMER1_CFG_H_
+#define TIMER1_CFG_H_
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The macros are plain integer arithmetic, so except TIMER1_CONFIG they also work in #if.
+ * The duration is reached in compare mode with the smallest pre-scaler that fits one
+ * compare period, or with 1024 and the smallest number of equal compare periods.
+ */
+
+#define TIMER1_CFG_MAX_COUNTS                65536ULL    /* Counts in one compare period */
+#define TIMER1_CFG_MAX_ISR_COUNT             255ULL      /* Compare periods per call back */
+
+/* Timer counts in ms with the pre-scaler division div */
+#define TIMER1_CFG_COUNTS(ms, div)           ((F_CPU) * 1ULL * (ms) / ((div) * 1000ULL))
+
+/* Smallest pre-scaler division reaching ms in one compare period, 1024 if none */
+#define TIMER1_CFG_DIVIDER(ms) \
+	((TIMER1_CFG_COUNTS (ms, 1ULL)   <= TIMER1_CFG_MAX_COUNTS) ? 1ULL   : \
+	 (TIMER1_CFG_COUNTS (ms, 8ULL)   <= TIMER1_CFG_MAX_COUNTS) ? 8ULL   : \
+	 (TIMER1_CFG_COUNTS (ms, 64ULL)  <= TIMER1_CFG_MAX_COUNTS) ? 64ULL  : \
+	 (TIMER1_CFG_COUNTS (ms, 256ULL) <= TIMER1_CFG_MAX_COUNTS) ? 256ULL : 1024ULL)
+
+/* TIMER1_Prescaler value of TIMER1_CFG_DIVIDER */
+#define TIMER1_CFG_PRESCALER(ms) \
+	((TIMER1_CFG_DIVIDER (ms) == 1ULL)  ? FCPU_1  : \
+	 (TIMER1_CFG_DIVIDER (ms) == 8ULL)  ? FCPU_8  : \
+	 (TIMER1_CFG_DIVIDER (ms) == 64ULL) ? FCPU_64 : \
+	 (TIMER1_CFG_DIVIDER (ms) == 256ULL) ? FCPU_256 : FCPU_1024)
+
+/* Number of compare interrupts making ms */
+#define TIMER1_CFG_ISR_COUNT(ms) \
+	((TIMER1_CFG_COUNTS (ms, TIMER1_CFG_DIVIDER (ms)) + TIMER1_CFG_MAX_COUNTS - 1ULL) / TIMER1_CFG_MAX_COUNTS)
+
+/* Compare value of each of the TIMER1_CFG_ISR_COUNT periods */
+#define TIMER1_CFG_COMPARE(ms) \
+	(TIMER1_CFG_COUNTS (ms, TIMER1_CFG_DIVIDER (ms)) / TIMER1_CFG_ISR_COUNT (ms) - 1ULL)
+
+/* The duration gives at least one timer count and does not need too many interrupts */
+#define TIMER1_CFG_IS_REACHABLE(ms) \
+	((TIMER1_CFG_COUNTS (ms, TIMER1_CFG_DIVIDER (ms)) >= 1ULL) && \
+	 (TIMER1_CFG_ISR_COUNT (ms) <= TIMER1_CFG_MAX_ISR_COUNT))
+
+/*
+ * TIMER1_ConfigType initializer calling back every ms.
+ * A duration that can not be reached makes a negative array size and fails the build.
+ */
+#define TIMER1_CONFIG(ms) \
+	{0, \
+	 (uint16)(TIMER1_CFG_COMPARE (ms) + 0 * sizeof (char [TIMER1_CFG_IS_REACHABLE (ms) ? 1 : -1])), \
+	 TIMER1_CFG_PRESCALER (ms), CTC, (uint8)TIMER1_CFG_ISR_COUNT (ms)}
+
+#endif /* TIMER1_CFG_H_ */
@@ -15,6 +15,26 @@
 
 #include "std_types.h"
 
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Sizes of the RX and TX ring buffers filled/drained by the UART interrupts.
+ * They must be a power of two (so the index wraps with a mask) and at most 128
+ * (so the free running uint8 indices can tell a full buffer from an empty one).
+ */
+#define UART_RX_BUFFER_SIZE                  64
+#define UART_TX_BUFFER_SIZE                  64
+
+#if ((UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1)) != 0 || UART_RX_BUFFER_SIZE > 128)
+#error "The UART RX Buffer Size Must Be A Power Of Two Not Greater Than 128"
+#endif
+
+#if ((UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1)) != 0 || UART_TX_BUFFER_SIZE > 128)
+#error "The UART TX Buffer Size Must Be A Power Of Two Not Greater Than 128"
+#endif
+
 /*******************************************************************************
  *                              Enumerations                                   *
  *******************************************************************************/
@@ -52,33 +72,52 @@ typedef struct
  * Description :
  * Functional responsible for Initialize the UART device by:
  * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
- * 2. Enable the UART.
+ * 2. Enable the UART with the RX Complete interrupt.
  * 3. Setup the UART baud rate.
+ * 4. Empty the RX and TX ring buffers.
+ * The I-bit must be enabled before using the driver as the data moves through the interrupts.
  */
 void UART_init(const UART_ConfigType* Config_Ptr);
 
 /*
  * Description :
- * Functional responsible for send byte to another UART device.
+ * Non-blocking write, copy up to size bytes into the TX ring buffer and start the transmission.
+ * Return the number of bytes queued, which is less than size if the buffer is full.
  */
-void UART_sendByte(const uint8 data);
+uint8 UART_write(const uint8 *data, uint8 size);
 
 /*
  * Description :
- * Functional responsible for receive byte from another UART device.
+ * Non-blocking read, move up to size received bytes from the RX ring buffer to data.
+ * Return the number of bytes copied, zero if nothing was received.
  */
-uint8 UART_recieveByte(void);
+uint8 UART_read(uint8 *data, uint8 size);
 
 /*
  * Description :
- * Send the required string through UART to the other UART device.
+ * Set the function called from the RX Complete ISR after every received byte,
+ * NULL_PTR to remove it. It must be short as it runs inside the ISR.
  */
-void UART_sendString(const uint8 *Str);
+void UART_setRxCallBack(void(*a_ptr)(void));
 
 /*
  * Description :
- * Receive the required string until the '#' symbol through UART from the other UART device.
+ * Return the number of received bytes waiting in the RX ring buffer.
  */
-void UART_receiveString(uint8 *Str); // Receive until #
+uint8 UART_available(void);
+
+/*
+ * Description :
+ * Functional responsible for send byte to another UART device.
+ * Wait only if the TX ring buffer is full.
+ */
+void UART_sendByte(const uint8 data);
+
+/*
+ * Description :
+ * Functional responsible for receive byte from another UART device.
+ * Wait until a byte is available in the RX ring buffer.
+ */
+uint8 UART_recieveByte(void);
 
 #endif /* UART_H_ */
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * Module: Uptime
+ *
+ * File Name: uptime.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the monotonic uptime clock
+ *
+ *******************************************************************************/
+
+#include "uptime.h"
+#include "timer1.h"
+#include <util/atomic.h>
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Read the tick count and the Timer1 counter as one instant */
+static void TIME_capture (uint32 *ticks, uint16 *count);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Return the Timer1 counts since SWTIMER_init, wraps around after 2^32 counts.
+ * Subtract two readings as uint32 to measure a duration.
+ */
+uint32 TIME_nowTicks (void)
+{
+	uint32 ticks = 0;
+	uint16 count = 0;
+
+	TIME_capture (&ticks, &count);
+	return ticks * (uint32)TIME_TICKS_PER_TIMER_TICK + count;
+}
+
+/*
+ * Description:
+ * Return the ms since SWTIMER_init, wraps around after 2^32 ms.
+ */
+uint32 TIME_nowMs (void)
+{
+	uint32 ticks = 0;
+	uint16 count = 0;
+
+	TIME_capture (&ticks, &count);
+	return ticks * SWTIMER_TICK_MS + count / (uint16)TIME_TICKS_PER_MS;
+}
+
+/*
+ * Description:
+ * Convert a number of Timer1 counts to us.
+ */
+uint32 TIME_ticksToUs (uint32 ticks)
+{
+	/* Split to keep ticks * 1000 from overflowing */
+	return (ticks / (uint32)TIME_TICKS_PER_MS) * 1000UL
+			+ ((ticks % (uint32)TIME_TICKS_PER_MS) * 1000UL) / (uint32)TIME_TICKS_PER_MS;
+}
+
+/*
+ * Description:
+ * Return TRUE if the uptime reached deadlineMs, correct across the wrap around
+ * for deadlines less than 2^31 ms away.
+ */
+bool TIME_isReached (uint32 deadlineMs)
+{
+	return ((sint32)(TIME_nowMs () - deadlineMs) >= 0) ? TRUE : FALSE;
+}
+
+static void TIME_capture (uint32 *ticks, uint16 *count)
+{
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		*ticks = SWTIMER_getTickCount ();
+		*count = TIMER1_getCount ();
+		/*
+		 * A compare match not served yet (interrupts off, or it came after the tick count
+		 * was read) means the counter already restarted, count it and read the counter again.
+		 */
+		if (TIMER1_isInterruptPending ())
+		{
+			(*ticks)++;
+			*count = TIMER1_getCount ();
+		}
+	}
+}
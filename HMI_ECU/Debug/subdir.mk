@@ -6,26 +6,47 @@
 C_SRCS += \
 ../gpio.c \
 ../hmi_main.c \
+../idle.c \
 ../keypad.c \
 ../lcd.c \
+../link.c \
+../profiler.c \
+../sw_timer.c \
 ../timer1.c \
-../uart.c 
+../timer2.c \
+../uart.c \
+../ui.c \
+../uptime.c 
 
 OBJS += \
 ./gpio.o \
 ./hmi_main.o \
+./idle.o \
 ./keypad.o \
 ./lcd.o \
+./link.o \
+./profiler.o \
+./sw_timer.o \
 ./timer1.o \
-./uart.o 
+./timer2.o \
+./uart.o \
+./ui.o \
+./uptime.o 
 
 C_DEPS += \
 ./gpio.d \
 ./hmi_main.d \
+./idle.d \
 ./keypad.d \
 ./lcd.d \
+./link.d \
+./profiler.d \
+./sw_timer.d \
 ./timer1.d \
-./uart.d 
+./timer2.d \
+./uart.d \
+./ui.d \
+./uptime.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -0,0 +1,192 @@
+/******************************************************************************
+ *
+ * Module: Idle
+ *
+ * File Name: idle.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the idle sleep manager
+ *
+ *******************************************************************************/
+
+#include "idle.h"
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#if IDLE_STATS_ENABLE
+#include "uptime.h"
+#include "link.h"
+#include <util/atomic.h>
+#endif
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+#if IDLE_STATS_ENABLE
+static volatile IDLE_StatsType g_stats;
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+#if IDLE_STATS_ENABLE
+/* Clear the statistics and start a new window now */
+static void IDLE_reset (void);
+
+static void IDLE_putLong (uint8 *buffer, uint32 value);
+#endif
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Select the idle sleep mode, the CPU stops but the timers, the UART, the TWI and the
+ * external interrupts keep running and wake it up. Called after SWTIMER_init.
+ */
+void IDLE_init (void)
+{
+	set_sleep_mode (SLEEP_MODE_IDLE);
+#if IDLE_STATS_ENABLE
+	IDLE_reset ();
+#endif
+}
+
+/*
+ * Description:
+ * Called with the interrupts disabled once the caller found nothing to do. Sleep until
+ * an interrupt and return after its ISR with the interrupts enabled. An interrupt raised
+ * after the check can't be missed, the sleep instruction runs right after sei.
+ */
+void IDLE_sleep (void)
+{
+#if IDLE_STATS_ENABLE
+	uint32 start = TIME_nowTicks ();
+	uint32 slept = 0;
+#endif
+
+	sleep_enable ();
+	sei ();
+	sleep_cpu ();
+	sleep_disable ();
+
+#if IDLE_STATS_ENABLE
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		g_stats.wakeUp = TIME_nowTicks ();
+
+		/* Whole ticks moved out at once, so the sum can't wrap around in a long window */
+		slept = g_stats.wakeUp - start + g_stats.idleCounts;
+		while (slept >= (uint32)TIME_TICKS_PER_TIMER_TICK)
+		{
+			slept -= (uint32)TIME_TICKS_PER_TIMER_TICK;
+			g_stats.idleTicks++;
+		}
+		g_stats.idleCounts = (uint16)slept;
+		if (g_stats.wakeUps != 0xFFFF)
+		{
+			g_stats.wakeUps++;
+		}
+		g_stats.waiting = TRUE;
+	}
+#endif
+}
+
+#if IDLE_STATS_ENABLE
+
+/*
+ * Description:
+ * Mark the start of an event handler, the first one after a wake up ends its latency.
+ */
+void IDLE_eventHandled (void)
+{
+	uint32 latency = 0;
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		if (g_stats.waiting && (g_stats.handled != 0xFFFF))
+		{
+			g_stats.waiting = FALSE;
+			latency = TIME_nowTicks () - g_stats.wakeUp;
+			if (latency > g_stats.latencyMax)
+			{
+				g_stats.latencyMax = latency;
+			}
+			g_stats.latencyTotal += latency;
+			g_stats.handled++;
+		}
+	}
+}
+
+/*
+ * Description:
+ * Send one LINK_MSG_IDLE_REPORT frame then restart the statistics.
+ */
+void IDLE_dump (void)
+{
+	uint8 report [IDLE_REPORT_LENGTH];
+	uint32 window = 0;
+	uint32 idle = 0;
+	uint16 wakeUps = 0;
+	uint16 handled = 0;
+	uint32 latencyMax = 0;
+	uint32 latencyTotal = 0;
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		window = SWTIMER_getTickCount () - g_stats.windowStart;     /* Right across the wrap around of the count */
+		idle = g_stats.idleTicks;
+		wakeUps = g_stats.wakeUps;
+		handled = g_stats.handled;
+		latencyMax = g_stats.latencyMax;
+		latencyTotal = g_stats.latencyTotal;
+		IDLE_reset ();
+	}
+
+	/* Per mille, in two steps once the 32 bits product could overflow (windows over 11 hours at 10 ms ticks) */
+	if (window == 0)
+	{
+		idle = 0;
+	}
+	else if (idle < (0xFFFFFFFFUL / 1000))
+	{
+		idle = (idle * 1000) / window;
+	}
+	else
+	{
+		idle = idle / (window / 1000);
+	}
+	report[0] = (uint8)(idle >> 8);
+	report[1] = (uint8)idle;
+	report[2] = (uint8)(wakeUps >> 8);
+	report[3] = (uint8)wakeUps;
+	report[4] = (uint8)(handled >> 8);
+	report[5] = (uint8)handled;
+	IDLE_putLong (&report[6], (handled == 0) ? 0 : TIME_ticksToUs (latencyTotal / handled));
+	IDLE_putLong (&report[10], TIME_ticksToUs (latencyMax));
+	LINK_sendFrame (LINK_MSG_IDLE_REPORT, report, IDLE_REPORT_LENGTH);
+}
+
+static void IDLE_reset (void)
+{
+	g_stats.windowStart = SWTIMER_getTickCount ();
+	g_stats.idleTicks = 0;
+	g_stats.idleCounts = 0;
+	g_stats.latencyMax = 0;
+	g_stats.latencyTotal = 0;
+	g_stats.wakeUps = 0;
+	g_stats.handled = 0;
+	g_stats.waiting = FALSE;
+}
+
+static void IDLE_putLong (uint8 *buffer, uint32 value)
+{
+	buffer[0] = (uint8)(value >> 24);
+	buffer[1] = (uint8)(value >> 16);
+	buffer[2] = (uint8)(value >> 8);
+	buffer[3] = (uint8)value;
+}
+
+#endif /* IDLE_STATS_ENABLE */
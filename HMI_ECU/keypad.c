@@ -11,158 +11,227 @@
  *******************************************************************************/
 #include "keypad.h"
 #include "gpio.h"
-#include <util/delay.h>
+#include "sw_timer.h"
+#include "profiler.h"
+#include <avr/pgmspace.h>
 
 /*******************************************************************************
- *                      Functions Prototypes(Private)                          *
+ *                                Definitions                                  *
  *******************************************************************************/
 
-#ifndef STANDARD_KEYPAD
+/* The rows and the columns are consecutive pins, each group is accessed at once */
+#define KEYPAD_ROWS_MASK                  (((1u << KEYPAD_NUM_ROWS) - 1) << KEYPAD_FIRST_ROW_PIN_ID)
+#define KEYPAD_COLS_MASK                  (((1u << KEYPAD_NUM_COLS) - 1) << KEYPAD_FIRST_COL_PIN_ID)
 
-#if (KEYPAD_NUM_COLS == 3)
-/*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x3 keypad
- */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number);
-#elif (KEYPAD_NUM_COLS == 4)
-/*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x4 keypad
- */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number);
+#if ((KEYPAD_NUM_COLS != 3) && (KEYPAD_NUM_COLS != 4))
+#error "The Keypad Must Be 4x3 Or 4x4"
 #endif
 
-#endif /* STANDARD_KEYPAD */
+#if ((KEYPAD_FIRST_ROW_PIN_ID + KEYPAD_NUM_ROWS) > 8 || (KEYPAD_FIRST_COL_PIN_ID + KEYPAD_NUM_COLS) > 8)
+#error "The Keypad Rows And Columns Must Fit In Their Ports"
+#endif
 
 /*******************************************************************************
- *                      Functions Definitions                                  *
+ *                                    Globals                                  *
  *******************************************************************************/
 
-uint8 KEYPAD_getPressedKey(void)
-{
-	uint8 col,row;
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID, PIN_OUTPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+1, PIN_OUTPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+2, PIN_OUTPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+3, PIN_OUTPUT);
-
-	GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID, KEYPAD_BUTTON_RELEASED);
-	GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+1, KEYPAD_BUTTON_RELEASED);
-	GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+2, KEYPAD_BUTTON_RELEASED);
-	GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+3, KEYPAD_BUTTON_RELEASED);
-
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+2, PIN_INPUT);
-#if(KEYPAD_NUM_COLS == 4)
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+3, PIN_INPUT);
-#endif
-	while(1)
-	{
-		for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
-		{
-			/* Set/Clear the row output pin */
-			GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
+/* Debounced state, bit (row * KEYPAD_NUM_COLS + col) is set while the button is pressed */
+static uint16 g_keysState = 0;
+static uint8 g_debounce [KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS];   /* Scans the raw state differed from g_keysState */
+static uint8 g_holdScans [KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS];  /* Scans the button is held down, saturates */
 
-			for(col=0 ; col<KEYPAD_NUM_COLS ; col++) /* loop for columns */
-			{
-				/* Check if the switch is pressed in this column */
-				if(GPIO_readPin(KEYPAD_COL_PORT_ID,KEYPAD_FIRST_COL_PIN_ID+col) == KEYPAD_BUTTON_PRESSED)
-				{
-#if (KEYPAD_NUM_COLS == 3)
+/* Event FIFO, written by the scan in the Timer1 ISR and read by KEYPAD_getEvent */
+static volatile KEYPAD_EventType g_events [KEYPAD_EVENT_QUEUE_SIZE];
+static volatile uint8 g_eventsHead = 0;
+static volatile uint8 g_eventsTail = 0;
+
+static SWTIMER_TimerType g_scanTimer;
+
+/* Key of every button index (row * KEYPAD_NUM_COLS + col), as printed on the proteus keypads */
+static const uint8 g_keyCodes [KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS] PROGMEM =
+{
 #ifdef STANDARD_KEYPAD
-					return ((row*KEYPAD_NUM_COLS)+col+1);
-#else
-					return KEYPAD_4x3_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
+	1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+#if (KEYPAD_NUM_COLS == 4)
+	13, 14, 15, 16
 #endif
+#elif (KEYPAD_NUM_COLS == 3)
+	1,   2,   3,                 /* The digits are numbers on this keypad, not ASCII */
+	4,   5,   6,
+	7,   8,   9,
+	'*', 0,   '#'
 #elif (KEYPAD_NUM_COLS == 4)
-#ifdef STANDARD_KEYPAD
-					return ((row*KEYPAD_NUM_COLS)+col+1);
-#else
-					return KEYPAD_4x4_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
+	'7', '8', '9', '%',
+	'4', '5', '6', '*',
+	'1', '2', '3', '-',
+	13,  '0', '=', '+'         /* 13 is the ASCII of Enter */
 #endif
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Periodic software timer call back, scan the matrix and queue the debounced changes */
+static void KEYPAD_scan(void);
+
+/* Return the raw state of all the buttons, bit (row * KEYPAD_NUM_COLS + col) set if pressed */
+static uint16 KEYPAD_readMatrix(void);
+
+/* Map the button index to its key and queue the event, dropped if the FIFO is full */
+static void KEYPAD_pushEvent(uint8 index, KEYPAD_EventKind kind);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Setup the rows as outputs (all released) and the columns as inputs once,
+ * then start scanning every KEYPAD_SCAN_PERIOD_MS from the software timers tick.
+ * Called after SWTIMER_init.
+ */
+void KEYPAD_init(void)
+{
+	uint8 i;
+
+	GPIO_DDR_REG(KEYPAD_ROW_PORT_ID) |= KEYPAD_ROWS_MASK;
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_HIGH)
+	GPIO_PORT_REG(KEYPAD_ROW_PORT_ID) &= ~KEYPAD_ROWS_MASK;
+#else
+	GPIO_PORT_REG(KEYPAD_ROW_PORT_ID) |= KEYPAD_ROWS_MASK;
 #endif
-				}
-			}
-			GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_RELEASED);
-		}
-	}	
-}
+	GPIO_DDR_REG(KEYPAD_COL_PORT_ID) &= ~KEYPAD_COLS_MASK;
 
-#ifndef STANDARD_KEYPAD
+	for(i=0 ; i<(KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS) ; i++)
+	{
+		g_debounce[i] = 0;
+		g_holdScans[i] = 0;
+	}
+	g_keysState = 0;
+	g_eventsHead = 0;
+	g_eventsTail = 0;
+
+	SWTIMER_start(&g_scanTimer, KEYPAD_SCAN_PERIOD_MS, SWTIMER_PERIODIC, KEYPAD_scan);
+}
 
-#if (KEYPAD_NUM_COLS == 3)
 /*
  * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x3 shape
+ * Non-blocking, move the oldest key event to event and return TRUE, or return FALSE if there is none
  */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number)
+bool KEYPAD_getEvent(KEYPAD_EventType *event)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
+	if(g_eventsHead == g_eventsTail)
 	{
-	case 10: keypad_button = '*'; // ASCII Code of *
-	break;
-	case 11: keypad_button = 0;
-	break;
-	case 12: keypad_button = '#'; // ASCII Code of #
-	break;
-	default: keypad_button = button_number;
-	break;
+		return FALSE;
 	}
-	return keypad_button;
-} 
+	event->key = g_events[g_eventsTail & (KEYPAD_EVENT_QUEUE_SIZE - 1)].key;
+	event->kind = g_events[g_eventsTail & (KEYPAD_EVENT_QUEUE_SIZE - 1)].kind;
+	g_eventsTail++;
+	return TRUE;
+}
 
-#elif (KEYPAD_NUM_COLS == 4)
+/*
+ * Description :
+ * Return TRUE if a key event is waiting, without taking it
+ */
+bool KEYPAD_isEventPending(void)
+{
+	return (g_eventsHead != g_eventsTail) ? TRUE : FALSE;
+}
+
+/*
+ * Description :
+ * Get the Keypad pressed button, waits for the next press event
+ */
+uint8 KEYPAD_getPressedKey(void)
+{
+	KEYPAD_EventType event;
+
+	do
+	{
+		while(!KEYPAD_getEvent(&event));
+	} while(event.kind != KEYPAD_PRESSED);
+	return event.key;
+}
+
+static void KEYPAD_scan(void)
+{
+	uint8 i;
+	uint16 raw;
+	uint16 mask;
+
+	PROF_BEGIN(PROF_KEYPAD_SCAN);
+	raw = KEYPAD_readMatrix();
+	for(i=0, mask=1 ; i<(KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS) ; i++, mask<<=1)
+	{
+		if((raw & mask) == (g_keysState & mask))
+		{
+			g_debounce[i] = 0;                      /* Same as the debounced state, a bounce is over */
+		}
+		else if(++g_debounce[i] >= KEYPAD_DEBOUNCE_SCANS)
+		{
+			/* The new state held for KEYPAD_DEBOUNCE_SCANS scans in a row */
+			g_debounce[i] = 0;
+			g_keysState ^= mask;
+			g_holdScans[i] = 0;
+			KEYPAD_pushEvent(i, (g_keysState & mask) ? KEYPAD_PRESSED : KEYPAD_RELEASED);
+		}
+
+		if((g_keysState & mask) && (g_holdScans[i] < KEYPAD_LONG_PRESS_SCANS))
+		{
+			if(++g_holdScans[i] == KEYPAD_LONG_PRESS_SCANS)
+			{
+				KEYPAD_pushEvent(i, KEYPAD_LONG_PRESSED);   /* Once per press */
+			}
+		}
+	}
+	PROF_END(PROF_KEYPAD_SCAN);
+}
 
 /*
  * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x4 shape
+ * Drive one row and read all the columns with one port access each, starting from
+ * the last row so every row shifts the ones before it to their bit positions.
  */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number)
+static uint16 KEYPAD_readMatrix(void)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
+	uint8 row = KEYPAD_NUM_ROWS;
+	uint8 rowBit = (uint8)(1u << (KEYPAD_FIRST_ROW_PIN_ID + KEYPAD_NUM_ROWS - 1));
+	uint8 cols;
+	uint16 raw = 0;
+
+	while(row-- > 0)
 	{
-	case 1: keypad_button = '7';
-	break;
-	case 2: keypad_button = '8';
-	break;
-	case 3: keypad_button = '9';
-	break;
-	case 4: keypad_button = '%'; // ASCII Code of %
-	break;
-	case 5: keypad_button = '4';
-	break;
-	case 6: keypad_button = '5';
-	break;
-	case 7: keypad_button = '6';
-	break;
-	case 8: keypad_button = '*'; /* ASCII Code of '*' */
-	break;
-	case 9: keypad_button = '1';
-	break;
-	case 10: keypad_button = '2';
-	break;
-	case 11: keypad_button = '3';
-	break;
-	case 12: keypad_button = '-'; /* ASCII Code of '-' */
-	break;
-	case 13: keypad_button = 13;  /* ASCII of Enter */
-	break;
-	case 14: keypad_button = '0';
-	break;
-	case 15: keypad_button = '='; /* ASCII Code of '=' */
-	break;
-	case 16: keypad_button = '+'; /* ASCII Code of '+' */
-	break;
-	default: keypad_button = button_number;
-	break;
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_HIGH)
+		GPIO_PORT_REG(KEYPAD_ROW_PORT_ID) = (GPIO_PORT_REG(KEYPAD_ROW_PORT_ID) & ~KEYPAD_ROWS_MASK) | rowBit;
+		__asm__ __volatile__ ("nop");                  /* Let the input synchronizer catch the columns */
+		cols = GPIO_PIN_REG(KEYPAD_COL_PORT_ID) & KEYPAD_COLS_MASK;
+#else
+		GPIO_PORT_REG(KEYPAD_ROW_PORT_ID) = (GPIO_PORT_REG(KEYPAD_ROW_PORT_ID) | KEYPAD_ROWS_MASK) & ~rowBit;
+		__asm__ __volatile__ ("nop");                  /* Let the input synchronizer catch the columns */
+		cols = ~GPIO_PIN_REG(KEYPAD_COL_PORT_ID) & KEYPAD_COLS_MASK;
+#endif
+		raw = (raw << KEYPAD_NUM_COLS) | (cols >> KEYPAD_FIRST_COL_PIN_ID);
+		rowBit >>= 1;
 	}
-	return keypad_button;
-} 
 
+	/* Release all the rows */
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_HIGH)
+	GPIO_PORT_REG(KEYPAD_ROW_PORT_ID) &= ~KEYPAD_ROWS_MASK;
+#else
+	GPIO_PORT_REG(KEYPAD_ROW_PORT_ID) |= KEYPAD_ROWS_MASK;
 #endif
+	return raw;
+}
 
-#endif /* STANDARD_KEYPAD */
+static void KEYPAD_pushEvent(uint8 index, KEYPAD_EventKind kind)
+{
+	if((uint8)(g_eventsHead - g_eventsTail) >= KEYPAD_EVENT_QUEUE_SIZE)
+	{
+		return;
+	}
+	g_events[g_eventsHead & (KEYPAD_EVENT_QUEUE_SIZE - 1)].key = pgm_read_byte(&g_keyCodes[index]);
+	g_events[g_eventsHead & (KEYPAD_EVENT_QUEUE_SIZE - 1)].kind = kind;
+	g_eventsHead++;
+}
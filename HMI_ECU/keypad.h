@@ -34,13 +34,62 @@
 #define KEYPAD_BUTTON_PRESSED            LOGIC_HIGH
 #define KEYPAD_BUTTON_RELEASED           LOGIC_LOW
 
+/* Scanner configurations, scan period must be a multiple of SWTIMER_TICK_MS */
+#define KEYPAD_SCAN_PERIOD_MS            10
+#define KEYPAD_DEBOUNCE_SCANS            3     /* Scans a new button state must hold */
+#define KEYPAD_LONG_PRESS_SCANS          100   /* Scans held down before the long press event, at most 255 */
+
+/* Events waiting in the FIFO, must be a power of two not greater than 128 */
+#define KEYPAD_EVENT_QUEUE_SIZE          16
+
+#if ((KEYPAD_EVENT_QUEUE_SIZE & (KEYPAD_EVENT_QUEUE_SIZE - 1)) != 0 || KEYPAD_EVENT_QUEUE_SIZE > 128)
+#error "The Keypad Event Queue Size Must Be A Power Of Two Not Greater Than 128"
+#endif
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	KEYPAD_PRESSED, KEYPAD_RELEASED, KEYPAD_LONG_PRESSED
+} KEYPAD_EventKind;
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint8 key;
+	KEYPAD_EventKind kind;
+} KEYPAD_EventType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
 /*
  * Description :
- * Get the Keypad pressed button
+ * Setup the rows as outputs (all released) and the columns as inputs once,
+ * then start scanning every KEYPAD_SCAN_PERIOD_MS from the software timers tick.
+ * Called after SWTIMER_init.
+ */
+void KEYPAD_init(void);
+
+/*
+ * Description :
+ * Non-blocking, move the oldest key event to event and return TRUE, or return FALSE if there is none
+ */
+bool KEYPAD_getEvent(KEYPAD_EventType *event);
+
+/*
+ * Description :
+ * Return TRUE if a key event is waiting, without taking it
+ */
+bool KEYPAD_isEventPending(void);
+
+/*
+ * Description :
+ * Get the Keypad pressed button, waits for the next press event
  */
 uint8 KEYPAD_getPressedKey(void);
 
@@ -17,6 +17,133 @@
 #include "common_macros.h"
 #include "LCD.h"
 #include "gpio.h"
+#include "profiler.h"
+#include "timer2.h"
+#include <util/atomic.h>
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define LCD_POWER_ON_MS                      40       /* Vcc rise to the first command */
+#define LCD_RESET_FIRST_US                   4100     /* After the first function set of the reset sequence */
+#define LCD_RESET_NEXT_US                    100      /* After the next ones */
+
+/* Worst case execution times at the slowest oscillator, used when the busy flag is not read */
+#define LCD_EXECUTION_US                     50       /* 37us most commands and data */
+#define LCD_CLEAR_US                         2000     /* 1.52ms clear display and return home */
+#define LCD_IS_SLOW_COMMAND(command)         ((command) < 0x04)
+
+/* Busy flag reads before giving up on a missing or dead display, around 20us each at 1MHz */
+#define LCD_BUSY_MAX_POLLS                   1000
+
+#if (LCD_BIT_MODE == 4)
+#define LCD_BUSY_PIN                         LCD_D7_PIN
+#elif (LCD_BIT_MODE == 8)
+#define LCD_BUSY_PIN                         PIN7_ID
+#endif
+
+#if (LCD_BIT_MODE == 4)
+#define LCD_NIBBLE_MASK                      ((1 << LCD_D4_PIN) | (1 << LCD_D5_PIN) | (1 << LCD_D6_PIN) | (1 << LCD_D7_PIN))
+
+/* Consecutive D4 --> D7 pins take bits 4 --> 7 of the value with one shift, any other order uses a table */
+#if ((LCD_D5_PIN == LCD_D4_PIN + 1) && (LCD_D6_PIN == LCD_D4_PIN + 2) && (LCD_D7_PIN == LCD_D4_PIN + 3))
+#if (LCD_D4_PIN >= 4)
+#define LCD_NIBBLE_BITS(value)               ((uint8)(((value) & 0xF0) << (LCD_D4_PIN - 4)))
+#else
+#define LCD_NIBBLE_BITS(value)               ((uint8)(((value) & 0xF0) >> (4 - LCD_D4_PIN)))
+#endif
+#else
+#define LCD_NIBBLE_TABLE
+#define LCD_NIBBLE_PINS(nibble)              ((GET_BIT (nibble, 0) << LCD_D4_PIN) | (GET_BIT (nibble, 1) << LCD_D5_PIN) | \
+                                              (GET_BIT (nibble, 2) << LCD_D6_PIN) | (GET_BIT (nibble, 3) << LCD_D7_PIN))
+#define LCD_NIBBLE_BITS(value)               (pgm_read_byte (&g_nibblePins[(uint8)(value) >> 4]))
+#endif
+#endif
+
+/* The queue is drained one byte per Timer2 compare interrupt, F_CPU/8 counts */
+#define LCD_DRAIN_PERIOD_US                  200
+#define LCD_DRAIN_COUNTS                     (((F_CPU / 8UL) * LCD_DRAIN_PERIOD_US) / 1000000UL)
+
+#if ((LCD_DRAIN_COUNTS < 2) || (LCD_DRAIN_COUNTS > 256))
+#error "The LCD Drain Period Can't Be Reached By Timer2"
+#endif
+
+#if (LCD_EXECUTION_US > LCD_DRAIN_PERIOD_US)
+#error "The LCD Drain Period Must Cover The Execution Time"
+#endif
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/* One byte waiting in the queue for the instruction (LOGIC_LOW) or data (LOGIC_HIGH) register */
+typedef struct
+{
+	uint8 rs;
+	uint8 value;
+} LCD_EntryType;
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+
+static uint8 g_frame [LCD_BUF_ROWS][LCD_BUF_COLS];   /* What the screen should show */
+static uint8 g_shown [LCD_BUF_ROWS][LCD_BUF_COLS];   /* What the screen shows, once the queue is drained */
+
+/* Queue written by LCD_push and drained by the Timer2 call back */
+static volatile LCD_EntryType g_queue [LCD_QUEUE_SIZE];
+static volatile uint8 g_queueHead = 0;
+static volatile uint8 g_queueTail = 0;
+static volatile bool g_draining = FALSE;     /* Timer2 is running */
+static volatile bool g_syncWrite = FALSE;    /* A blocking write owns the bus, the drain waits */
+#if (LCD_USE_BUSY_FLAG == 0)
+static volatile uint8 g_drainWaits = 0;      /* Drain periods left for the last instruction */
+#endif
+
+static const TIMER2_ConfigType g_drainTimer = {LCD_DRAIN_COUNTS - 1, TIMER2_FCPU_8};
+
+#ifdef LCD_NIBBLE_TABLE
+/* Data port bits of every nibble, D4 --> D7 wired in any order */
+static const uint8 g_nibblePins [16] PROGMEM =
+{
+	LCD_NIBBLE_PINS (0),  LCD_NIBBLE_PINS (1),  LCD_NIBBLE_PINS (2),  LCD_NIBBLE_PINS (3),
+	LCD_NIBBLE_PINS (4),  LCD_NIBBLE_PINS (5),  LCD_NIBBLE_PINS (6),  LCD_NIBBLE_PINS (7),
+	LCD_NIBBLE_PINS (8),  LCD_NIBBLE_PINS (9),  LCD_NIBBLE_PINS (10), LCD_NIBBLE_PINS (11),
+	LCD_NIBBLE_PINS (12), LCD_NIBBLE_PINS (13), LCD_NIBBLE_PINS (14), LCD_NIBBLE_PINS (15)
+};
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Latch value on the data bus with one enable pulse, bits 4 --> 7 only in 4-bit mode */
+static void LCD_strobe(uint8 value);
+
+/* Write one byte to the instruction (rs = LOGIC_LOW) or data (rs = LOGIC_HIGH) register */
+static void LCD_write(uint8 rs, uint8 value);
+
+#if (LCD_USE_BUSY_FLAG == 1)
+/* Read the busy flag once, TRUE while the LCD executes the last instruction */
+static bool LCD_readBusyFlag(void);
+
+/* Wait until the LCD finishes the last instruction */
+static void LCD_waitWhileBusy(void);
+#endif
+
+/* Return the set DDRAM address command of the cell at row and col */
+static uint8 LCD_cursorCommand(uint8 row, uint8 col);
+
+/* Wait for the queue to drain and take the bus for a blocking write, needs the I-bit */
+static void LCD_beginSyncWrite(void);
+
+/* Queue one byte and start the drain, with the interrupts disabled. Return FALSE if the queue is full */
+static bool LCD_push(uint8 rs, uint8 value);
+
+/* Timer2 call back, send the next queued byte once the LCD is ready */
+static void LCD_drain(void);
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -35,6 +162,7 @@ void LCD_init(void)
 	GPIO_setupPinDirection (LCD_RW_PORT, LCD_RW_PIN, PIN_OUTPUT);
 	GPIO_setupPinDirection (LCD_EN_PORT, LCD_EN_PIN, PIN_OUTPUT);
 	GPIO_writePin (LCD_RW_PORT, LCD_RW_PIN, LOGIC_LOW);
+	GPIO_writePin (LCD_RS_PORT, LCD_RS_PIN, LOGIC_LOW);
 
 #if (LCD_BIT_MODE == 4)
 	/* Configure 4 pins in the data port as output pins */
@@ -42,66 +170,67 @@ void LCD_init(void)
 	GPIO_setupPinDirection (LCD_DATA_PORT, LCD_D5_PIN, PIN_OUTPUT);
 	GPIO_setupPinDirection (LCD_DATA_PORT, LCD_D6_PIN, PIN_OUTPUT);
 	GPIO_setupPinDirection (LCD_DATA_PORT, LCD_D7_PIN, PIN_OUTPUT);
-
-	/* use 2-line lcd + 4-bit Data Mode + 5*7 dot display Mode */
-	LCD_sendCommand (LCD_4BITS_INIT1);
-	LCD_sendCommand (LCD_4BITS_INIT2);
-	LCD_sendCommand (LCD_4BITS_MODE);
-
 #elif (LCD_BIT_MODE == 8)
 	/* Configure the data port as output port */
 	GPIO_setupPortDirection (LCD_DATA_PORT, PORT_OUTPUT);
+#endif
 
+	/*
+	 * Reset by instruction, the busy flag can't be read until the interface length is set.
+	 * Three 8-bit function sets, only their upper nibble is seen in 4-bit mode.
+	 */
+	_delay_ms(LCD_POWER_ON_MS);
+	LCD_strobe (LCD_8BITS_MODE);
+	_delay_us(LCD_RESET_FIRST_US);
+	LCD_strobe (LCD_8BITS_MODE);
+	_delay_us(LCD_RESET_NEXT_US);
+	LCD_strobe (LCD_8BITS_MODE);
+	_delay_us(LCD_RESET_NEXT_US);
+
+#if (LCD_BIT_MODE == 4)
+	/* Switch to 4-bit with one nibble then use 2-line lcd + 4-bit Data Mode + 5*7 dot display Mode */
+	LCD_strobe (LCD_4BITS_MODE);
+	_delay_us(LCD_RESET_NEXT_US);
+	LCD_sendCommand (LCD_4BITS_MODE);
+#elif (LCD_BIT_MODE == 8)
 	/* use 2-line lcd + 8-bit Data Mode + 5*7 dot display Mode */
 	LCD_sendCommand (LCD_8BITS_MODE);
 #endif
 
 	LCD_sendCommand(DISPLAY_ON_CURSOR_OFF);
-	LCD_sendCommand(CLEAR_DISPLAY);            /* Clear LCD at the beginning */
+	LCD_clearScreen();                         /* Clear LCD at the beginning */
+	LCD_bufClear();
+
+	g_queueHead = 0;
+	g_queueTail = 0;
+	TIMER2_setCallBack(LCD_drain);
 }
 
 /*
  * Description :
- * Send the required command to the screen
+ * Send the required command to the screen after the queued ones.
+ * Blocking and needs the I-bit while the queue is not empty, not for the ISRs.
  */
 void LCD_sendCommand(uint8 command)
 {
-	/* Instruction Mode RS=0 */
-	GPIO_writePin(LCD_RS_PORT, LCD_RS_PIN, LOGIC_LOW);
-	_delay_ms(1);            /* delay for processing Tas = 50ns */
-
-	GPIO_writePin(LCD_EN_PORT, LCD_EN_PIN, LOGIC_HIGH);
-	_delay_ms(1);            /* delay for processing Tpw - Tdws = 190ns */
-
-#if (LCD_BIT_MODE == 4)
-	/* out the last 4 bits of the required command to the data bus D4 --> D7 */
-	GPIO_writePin(LCD_DATA_PORT, LCD_D4_PIN, GET_BIT (command, 4));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D5_PIN, GET_BIT (command, 5));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D6_PIN, GET_BIT (command, 6));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D7_PIN, GET_BIT (command, 7));
-	_delay_ms(1);            /* delay for processing Tdsw = 100ns */
-
-	GPIO_writePin(LCD_EN_PORT, LCD_EN_PIN, LOGIC_LOW);
-	_delay_ms(1);            /* delay for processing Th = 13ns */
-
-	GPIO_writePin(LCD_EN_PORT, LCD_EN_PIN, LOGIC_HIGH);
-	_delay_ms(1);            /* delay for processing Tpw - Tdws = 190ns */
-
-	/* out the first 4 bits of the required command to the data bus D4 --> D7 */
-	GPIO_writePin(LCD_DATA_PORT, LCD_D4_PIN, GET_BIT (command, 0));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D5_PIN, GET_BIT (command, 1));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D6_PIN, GET_BIT (command, 2));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D7_PIN, GET_BIT (command, 3));
-	_delay_ms(1);           /* delay for processing Tdsw = 100ns */
-
-#elif (LCD_BIT_MODE == 8)
-	/* out the required command to the data bus D0 --> D7 */
-	GPIO_writePort(LCD_DATA_PORT, command);
-	_delay_ms(1);           /* delay for processing Tdsw = 100ns */
+	PROF_BEGIN(PROF_LCD_SEND_COMMAND);
+	LCD_beginSyncWrite();
+#if (LCD_USE_BUSY_FLAG == 1)
+	LCD_waitWhileBusy();                       /* Wait for the last instruction instead of delaying after it */
 #endif
-
-	GPIO_writePin(LCD_EN_PORT, LCD_EN_PIN, LOGIC_LOW);
-	_delay_ms(1);           /* delay for processing Th = 13ns */
+	LCD_write (LOGIC_LOW, command);            /* Instruction Mode RS=0 */
+#if (LCD_USE_BUSY_FLAG == 0)
+	if (LCD_IS_SLOW_COMMAND (command))
+	{
+		_delay_us(LCD_CLEAR_US);
+	}
+	else
+	{
+		_delay_us(LCD_EXECUTION_US);
+	}
+#endif
+	g_syncWrite = FALSE;
+	PROF_END(PROF_LCD_SEND_COMMAND);
 }
 
 /*
@@ -110,42 +239,17 @@ void LCD_sendCommand(uint8 command)
  */
 void LCD_sendData(uint8 data)
 {
-	/* Data Mode RS=1 */
-	GPIO_writePin(LCD_RS_PORT, LCD_RS_PIN, LOGIC_HIGH);
-	_delay_ms(1);            /* delay for processing Tas = 50ns */
-
-	GPIO_writePin(LCD_EN_PORT, LCD_EN_PIN, LOGIC_HIGH);
-	_delay_ms(1);            /* delay for processing Tpw - Tdws = 190ns */
-
-#if (LCD_BIT_MODE == 4)
-	/* out the last 4 bits of the required data to the data bus D4 --> D7 */
-	GPIO_writePin(LCD_DATA_PORT, LCD_D4_PIN, GET_BIT (data, 4));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D5_PIN, GET_BIT (data, 5));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D6_PIN, GET_BIT (data, 6));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D7_PIN, GET_BIT (data, 7));
-	_delay_ms(1);            /* delay for processing Tdsw = 100ns */
-
-	GPIO_writePin(LCD_EN_PORT, LCD_EN_PIN, LOGIC_LOW);
-	_delay_ms(1);            /* delay for processing Th = 13ns */
-
-	GPIO_writePin(LCD_EN_PORT, LCD_EN_PIN, LOGIC_HIGH);
-	_delay_ms(1);            /* delay for processing Tpw - Tdws = 190ns */
-
-	/* out the first 4 bits of the required data to the data bus D4 --> D7 */
-	GPIO_writePin(LCD_DATA_PORT, LCD_D4_PIN, GET_BIT (data, 0));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D5_PIN, GET_BIT (data, 1));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D6_PIN, GET_BIT (data, 2));
-	GPIO_writePin(LCD_DATA_PORT, LCD_D7_PIN, GET_BIT (data, 3));
-	_delay_ms(1);            /* delay for processing Tdsw = 100ns */
-
-#elif (LCD_BIT_MODE == 8)
-	/* out the required data to the data bus D0 --> D7 */
-	GPIO_writePort(LCD_DATA_PORT, data);
-	_delay_ms(1);           /* delay for processing Tdsw = 100ns */
+	PROF_BEGIN(PROF_LCD_SEND_DATA);
+	LCD_beginSyncWrite();
+#if (LCD_USE_BUSY_FLAG == 1)
+	LCD_waitWhileBusy();
 #endif
-
-	GPIO_writePin(LCD_EN_PORT, LCD_EN_PIN, LOGIC_LOW);
-	_delay_ms(1);           /* delay for processing Th = 13ns */
+	LCD_write (LOGIC_HIGH, data);              /* Data Mode RS=1 */
+#if (LCD_USE_BUSY_FLAG == 0)
+	_delay_us(LCD_EXECUTION_US);
+#endif
+	g_syncWrite = FALSE;
+	PROF_END(PROF_LCD_SEND_DATA);
 }
 
 /*
@@ -163,30 +267,26 @@ void LCD_displayString(char * ptr)
 
 /*
  * Description :
- * Move the cursor to a specified row and column index on the screen
+ * Display the required string from the flash on the screen
  */
-void LCD_moveCursor(uint8 row, uint8 col)
+void LCD_displayString_P(const char * ptr)
 {
-	uint8 position = FIRST_ROW_ADDRESS;
+	uint8 character;
 
-	/* Calculate the required address in the LCD DDRAM */
-	switch (row)
+	for (character = pgm_read_byte (ptr); character != '\0'; character = pgm_read_byte (++ptr))
 	{
-	case 0:
-		position = FIRST_ROW_ADDRESS + col;
-		break;
-	case 1:
-		position = SECOND_ROW_ADDRESS + col;
-		break;
-	case 2:
-		position = THIRD_ROW_ADDRESS + col;
-		break;
-	case 3:
-		position = FOURTH_ROW_ADDRESS + col;
+		LCD_sendData(character);
 	}
+}
+
+/*
+ * Description :
+ * Move the cursor to a specified row and column index on the screen
+ */
+void LCD_moveCursor(uint8 row, uint8 col)
+{
 	/* Move the LCD cursor to this specific address */
-	SET_BIT (position, PIN7_ID);
-	LCD_sendCommand(position);
+	LCD_sendCommand(LCD_cursorCommand(row, col));
 }
 
 /*
@@ -195,7 +295,18 @@ void LCD_moveCursor(uint8 row, uint8 col)
  */
 void LCD_clearScreen(void)
 {
+	uint8 row, col;
+
 	LCD_sendCommand (CLEAR_DISPLAY);   /* Send clear display command */
+
+	/* The display RAM is filled with spaces */
+	for (row = 0; row < LCD_BUF_ROWS; row++)
+	{
+		for (col = 0; col < LCD_BUF_COLS; col++)
+		{
+			g_shown[row][col] = ' ';
+		}
+	}
 }
 
 /*
@@ -225,3 +336,373 @@ void LCD_createCharacter(uint8 location, uint8* character)
 		LCD_sendData (character[i]);
 	}
 }
+
+/*
+ * Description :
+ * Fill the frame buffer with spaces, nothing is sent to the screen until it is flushed
+ */
+void LCD_bufClear(void)
+{
+	uint8 row, col;
+
+	for (row = 0; row < LCD_BUF_ROWS; row++)
+	{
+		for (col = 0; col < LCD_BUF_COLS; col++)
+		{
+			g_frame[row][col] = ' ';
+		}
+	}
+}
+
+/*
+ * Description :
+ * Write the string to the frame buffer from row and col, it is cut at the end of the row
+ */
+void LCD_bufPrint(uint8 row, uint8 col, const char *str)
+{
+	if (row >= LCD_BUF_ROWS)
+	{
+		return;
+	}
+	for (; (col < LCD_BUF_COLS) && (*str != '\0'); col++, str++)
+	{
+		g_frame[row][col] = *str;
+	}
+}
+
+/*
+ * Description :
+ * Same as LCD_bufPrint for a string in the flash
+ */
+void LCD_bufPrint_P(uint8 row, uint8 col, const char *str)
+{
+	uint8 character;
+
+	if (row >= LCD_BUF_ROWS)
+	{
+		return;
+	}
+	for (character = pgm_read_byte (str); (col < LCD_BUF_COLS) && (character != '\0'); character = pgm_read_byte (++str))
+	{
+		g_frame[row][col] = character;
+		col++;
+	}
+}
+
+/*
+ * Description :
+ * Clear the frame buffer and print every string of the screen table, all in the flash
+ */
+void LCD_bufScreen_P(const LCD_ScreenItemType *screen)
+{
+	const char *str;
+
+	LCD_bufClear();
+	for (str = pgm_read_ptr (&screen -> str); str != NULL_PTR; str = pgm_read_ptr (&screen -> str))
+	{
+		LCD_bufPrint_P (pgm_read_byte (&screen -> row), pgm_read_byte (&screen -> col), str);
+		screen++;
+	}
+}
+
+/*
+ * Description :
+ * Queue at most maxCells changed cells of the frame buffer, with a cursor move only at the
+ * start of every run of changed cells. Stops early when the queue is full.
+ * Return TRUE when everything in the frame buffer is sent or queued.
+ */
+bool LCD_flushSlice(uint8 maxCells)
+{
+	bool queued = TRUE;
+	uint8 row, col;
+	/* Where the LCD cursor is after the last sent cell, unknown at the start of every slice */
+	uint8 cursorRow = LCD_BUF_ROWS;
+	uint8 cursorCol = 0;
+
+	for (row = 0; row < LCD_BUF_ROWS; row++)
+	{
+		for (col = 0; col < LCD_BUF_COLS; col++)
+		{
+			if (g_frame[row][col] == g_shown[row][col])
+			{
+				continue;
+			}
+			if (maxCells == 0)
+			{
+				return FALSE;
+			}
+			ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+			{
+				/* Room for the cursor move and the cell */
+				if ((uint8)(g_queueHead - g_queueTail) > (LCD_QUEUE_SIZE - 2))
+				{
+					queued = FALSE;
+				}
+				else
+				{
+					if ((row != cursorRow) || (col != cursorCol))
+					{
+						(void)LCD_push (LOGIC_LOW, LCD_cursorCommand (row, col));
+					}
+					(void)LCD_push (LOGIC_HIGH, g_frame[row][col]);
+				}
+			}
+			if (!queued)
+			{
+				return FALSE;
+			}
+			g_shown[row][col] = g_frame[row][col];
+			cursorRow = row;
+			cursorCol = col + 1;
+			maxCells--;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Queue all the changed cells of the frame buffer, waits for room in the queue
+ */
+void LCD_flush(void)
+{
+	while (!LCD_flushSlice (LCD_BUF_ROWS * LCD_BUF_COLS));
+}
+
+/*
+ * Description :
+ * Queue a command without waiting, safe from the ISRs.
+ * Return FALSE if the queue is full.
+ */
+bool LCD_queueCommand(uint8 command)
+{
+	bool queued = FALSE;
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		queued = LCD_push (LOGIC_LOW, command);
+	}
+	return queued;
+}
+
+/*
+ * Description :
+ * Queue a character without waiting, safe from the ISRs.
+ * Return FALSE if the queue is full.
+ */
+bool LCD_queueData(uint8 data)
+{
+	bool queued = FALSE;
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		queued = LCD_push (LOGIC_HIGH, data);
+	}
+	return queued;
+}
+
+/*
+ * Description :
+ * Queue a cursor move then the string without waiting, safe from the ISRs.
+ * Nothing is queued and FALSE is returned if the queue has no room for all of it.
+ */
+bool LCD_queueString(uint8 row, uint8 col, const char *str)
+{
+	bool queued = FALSE;
+	uint8 length = 0;
+
+	while (str[length] != '\0')
+	{
+		length++;
+	}
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		if ((uint8)(g_queueHead - g_queueTail) < (LCD_QUEUE_SIZE - length))
+		{
+			(void)LCD_push (LOGIC_LOW, LCD_cursorCommand (row, col));
+			for (; *str != '\0'; str++)
+			{
+				(void)LCD_push (LOGIC_HIGH, *str);
+			}
+			queued = TRUE;
+		}
+	}
+	return queued;
+}
+
+static void LCD_strobe(uint8 value)
+{
+#if (LCD_BIT_MODE == 4)
+	/* out the last 4 bits of value to the data bus D4 --> D7 with one port write */
+	GPIO_PORT_REG(LCD_DATA_PORT) = (GPIO_PORT_REG(LCD_DATA_PORT) & ~LCD_NIBBLE_MASK) | LCD_NIBBLE_BITS (value);
+#elif (LCD_BIT_MODE == 8)
+	/* out value to the data bus D0 --> D7 */
+	GPIO_writePortFast(LCD_DATA_PORT, value);
+#endif
+
+	GPIO_writePinFast(LCD_EN_PORT, LCD_EN_PIN, LOGIC_HIGH);
+	_delay_us(1);            /* delay for processing PWEH = 230ns */
+	GPIO_writePinFast(LCD_EN_PORT, LCD_EN_PIN, LOGIC_LOW);
+	_delay_us(1);            /* delay for processing tcycE - PWEH = 270ns */
+}
+
+static void LCD_write(uint8 rs, uint8 value)
+{
+	GPIO_writePinFast(LCD_RS_PORT, LCD_RS_PIN, rs);     /* tAS = 40ns is covered by the next instructions */
+	LCD_strobe(value);
+#if (LCD_BIT_MODE == 4)
+	LCD_strobe(value << 4);  /* then the first 4 bits */
+#endif
+}
+
+#if (LCD_USE_BUSY_FLAG == 1)
+static bool LCD_readBusyFlag(void)
+{
+	uint8 busy;
+
+	/* Release the data bus and read the busy flag on D7 with RS=0 and RW=1 */
+#if (LCD_BIT_MODE == 4)
+	GPIO_DDR_REG(LCD_DATA_PORT) &= ~LCD_NIBBLE_MASK;
+#elif (LCD_BIT_MODE == 8)
+	GPIO_DDR_REG(LCD_DATA_PORT) = PORT_INPUT;
+#endif
+	GPIO_writePinFast(LCD_RS_PORT, LCD_RS_PIN, LOGIC_LOW);
+	GPIO_writePinFast(LCD_RW_PORT, LCD_RW_PIN, LOGIC_HIGH);
+
+	GPIO_writePinFast(LCD_EN_PORT, LCD_EN_PIN, LOGIC_HIGH);
+	_delay_us(1);            /* delay for processing tDDR = 160ns */
+	busy = GPIO_readPinFast(LCD_DATA_PORT, LCD_BUSY_PIN);
+	GPIO_writePinFast(LCD_EN_PORT, LCD_EN_PIN, LOGIC_LOW);
+	_delay_us(1);
+#if (LCD_BIT_MODE == 4)
+	/* Clock out the address counter low nibble, not needed */
+	GPIO_writePinFast(LCD_EN_PORT, LCD_EN_PIN, LOGIC_HIGH);
+	_delay_us(1);
+	GPIO_writePinFast(LCD_EN_PORT, LCD_EN_PIN, LOGIC_LOW);
+	_delay_us(1);
+#endif
+
+	GPIO_writePinFast(LCD_RW_PORT, LCD_RW_PIN, LOGIC_LOW);
+#if (LCD_BIT_MODE == 4)
+	GPIO_DDR_REG(LCD_DATA_PORT) |= LCD_NIBBLE_MASK;
+#elif (LCD_BIT_MODE == 8)
+	GPIO_DDR_REG(LCD_DATA_PORT) = PORT_OUTPUT;
+#endif
+	return (busy == LOGIC_HIGH) ? TRUE : FALSE;
+}
+
+static void LCD_waitWhileBusy(void)
+{
+	uint16 polls = 0;
+
+	while (LCD_readBusyFlag() && (polls < LCD_BUSY_MAX_POLLS))
+	{
+		polls++;
+	}
+}
+#endif
+
+static uint8 LCD_cursorCommand(uint8 row, uint8 col)
+{
+	uint8 position = FIRST_ROW_ADDRESS;
+
+	/* Calculate the required address in the LCD DDRAM */
+	switch (row)
+	{
+	case 0:
+		position = FIRST_ROW_ADDRESS + col;
+		break;
+	case 1:
+		position = SECOND_ROW_ADDRESS + col;
+		break;
+	case 2:
+		position = THIRD_ROW_ADDRESS + col;
+		break;
+	case 3:
+		position = FOURTH_ROW_ADDRESS + col;
+	}
+	SET_BIT (position, PIN7_ID);
+	return position;
+}
+
+static void LCD_beginSyncWrite(void)
+{
+	bool taken = FALSE;
+
+	while (!taken)
+	{
+		ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+		{
+			if (g_queueHead == g_queueTail)
+			{
+				g_syncWrite = TRUE;
+				taken = TRUE;
+			}
+		}
+	}
+#if (LCD_USE_BUSY_FLAG == 0)
+	/* Cover the last queued instruction, at most one drain period off */
+	while (g_drainWaits > 0)
+	{
+		_delay_us(LCD_DRAIN_PERIOD_US);
+		g_drainWaits--;
+	}
+#endif
+}
+
+static bool LCD_push(uint8 rs, uint8 value)
+{
+	if ((uint8)(g_queueHead - g_queueTail) >= LCD_QUEUE_SIZE)
+	{
+		return FALSE;
+	}
+	g_queue[g_queueHead & (LCD_QUEUE_SIZE - 1)].rs = rs;
+	g_queue[g_queueHead & (LCD_QUEUE_SIZE - 1)].value = value;
+	g_queueHead++;
+	if (!g_draining)
+	{
+		g_draining = TRUE;
+		TIMER2_init (&g_drainTimer);
+	}
+	return TRUE;
+}
+
+static void LCD_drain(void)
+{
+	uint8 rs;
+	uint8 value;
+
+	if (g_syncWrite)
+	{
+		return;
+	}
+#if (LCD_USE_BUSY_FLAG == 1)
+	if (LCD_readBusyFlag())
+	{
+		return;
+	}
+#else
+	if (g_drainWaits > 0)
+	{
+		g_drainWaits--;
+		return;
+	}
+#endif
+	if (g_queueHead == g_queueTail)
+	{
+		TIMER2_deInit ();       /* Idle until the next push */
+		g_draining = FALSE;
+		return;
+	}
+
+	rs = g_queue[g_queueTail & (LCD_QUEUE_SIZE - 1)].rs;
+	value = g_queue[g_queueTail & (LCD_QUEUE_SIZE - 1)].value;
+	g_queueTail++;
+	LCD_write (rs, value);
+#if (LCD_USE_BUSY_FLAG == 0)
+	if ((rs == LOGIC_LOW) && LCD_IS_SLOW_COMMAND (value))
+	{
+		g_drainWaits = LCD_CLEAR_US / LCD_DRAIN_PERIOD_US;
+	}
+#endif
+}
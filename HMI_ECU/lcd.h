@@ -27,6 +27,12 @@
 #error "The Bit Mode Is Wrong"
 #endif
 
+/* LCD_TIMING_MODES: 1 poll the busy flag over RW, 0 wait the worst case times for boards with RW grounded */
+#define LCD_USE_BUSY_FLAG 1
+#if (LCD_USE_BUSY_FLAG != 1 && LCD_USE_BUSY_FLAG != 0)
+#error "The Timing Mode Is Wrong"
+#endif
+
 /* Static Configurations */
 #define LCD_RS_PORT                          PORTB_ID
 #define LCD_RS_PIN                           PIN0_ID
@@ -47,13 +53,25 @@
 #endif
 
 /* LCD_COMMANDS */
-#define LCD_4BITS_INIT1                      0x33
-#define LCD_4BITS_INIT2                      0x32
 #define LCD_4BITS_MODE                       0x28
 #define LCD_8BITS_MODE                       0x38
 #define DISPLAY_ON_CURSOR_OFF                0x0C
 #define CLEAR_DISPLAY                        0x01
 
+/* LCD_FRAME_BUFFER */
+#define LCD_BUF_ROWS                         2
+#define LCD_BUF_COLS                         16
+#define LCD_FLUSH_SLICE_CELLS                4        /* Cells sent per LCD_flushSlice from the main loop */
+#if ((LCD_BUF_ROWS > 4) || ((LCD_BUF_ROWS * LCD_BUF_COLS) > 255))
+#error "The Frame Buffer Is Too Big"
+#endif
+
+/* LCD_QUEUE: bytes waiting for the Timer2 drain, must be a power of two */
+#define LCD_QUEUE_SIZE                       64
+#if ((LCD_QUEUE_SIZE & (LCD_QUEUE_SIZE - 1)) != 0 || LCD_QUEUE_SIZE > 128)
+#error "The LCD Queue Size Must Be A Power Of Two Up To 128"
+#endif
+
 /* LCD_MEMORIES */
 #define FIRST_ROW_ADDRESS                    0x00
 #define SECOND_ROW_ADDRESS                   0x40
@@ -61,6 +79,18 @@
 #define FOURTH_ROW_ADDRESS                   0x50
 #define CGROM_ADDRESS                        0x40
 
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/* One string of a screen table in flash, the table ends with a NULL_PTR string */
+typedef struct
+{
+	uint8 row;
+	uint8 col;
+	const char *str;                 /* PROGMEM string */
+} LCD_ScreenItemType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
@@ -75,7 +105,8 @@ void LCD_init(void);
 
 /*
  * Description :
- * Send the required command to the screen
+ * Send the required command to the screen after the queued ones.
+ * Blocking and needs the I-bit while the queue is not empty, not for the ISRs.
  */
 void LCD_sendCommand(uint8 command);
 
@@ -91,6 +122,12 @@ void LCD_sendData(uint8 data);
  */
 void LCD_displayString(char * ptr);
 
+/*
+ * Description :
+ * Display the required string from the flash on the screen
+ */
+void LCD_displayString_P(const char * ptr);
+
 /*
  * Description :
  * Move the cursor to a specified row and column index on the screen
@@ -115,4 +152,63 @@ void LCD_displayInteger(sint32 num);
  */
 void LCD_createCharacter(uint8 location, uint8* character);
 
+/*
+ * Description :
+ * Fill the frame buffer with spaces, nothing is sent to the screen until it is flushed
+ */
+void LCD_bufClear(void);
+
+/*
+ * Description :
+ * Write the string to the frame buffer from row and col, it is cut at the end of the row
+ */
+void LCD_bufPrint(uint8 row, uint8 col, const char *str);
+
+/*
+ * Description :
+ * Same as LCD_bufPrint for a string in the flash
+ */
+void LCD_bufPrint_P(uint8 row, uint8 col, const char *str);
+
+/*
+ * Description :
+ * Clear the frame buffer and print every string of the screen table, all in the flash
+ */
+void LCD_bufScreen_P(const LCD_ScreenItemType *screen);
+
+/*
+ * Description :
+ * Queue at most maxCells changed cells of the frame buffer, with a cursor move only at the
+ * start of every run of changed cells. Stops early when the queue is full.
+ * Return TRUE when everything in the frame buffer is sent or queued.
+ */
+bool LCD_flushSlice(uint8 maxCells);
+
+/*
+ * Description :
+ * Queue all the changed cells of the frame buffer, waits for room in the queue
+ */
+void LCD_flush(void);
+
+/*
+ * Description :
+ * Queue a command without waiting, safe from the ISRs.
+ * Return FALSE if the queue is full.
+ */
+bool LCD_queueCommand(uint8 command);
+
+/*
+ * Description :
+ * Queue a character without waiting, safe from the ISRs.
+ * Return FALSE if the queue is full.
+ */
+bool LCD_queueData(uint8 data);
+
+/*
+ * Description :
+ * Queue a cursor move then the string without waiting, safe from the ISRs.
+ * Nothing is queued and FALSE is returned if the queue has no room for all of it.
+ */
+bool LCD_queueString(uint8 row, uint8 col, const char *str);
+
 #endif /* LCD_H_ */
@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ * Module: Profiler
+ *
+ * File Name: profiler.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the hot path profiler on the uptime clock
+ *
+ *******************************************************************************/
+
+#include "profiler.h"
+
+#if PROF_ENABLE
+
+#include "link.h"
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+static PROF_ProbeType g_probes [PROF_PROBES_COUNT];
+static uint32 g_overhead = 0;           /* Counts of an empty probe */
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Clear the statistics of all the probes */
+static void PROF_reset (void);
+
+/* Write value big endian in 4 bytes */
+static void PROF_putLong (uint8 *buffer, uint32 value);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Clear the table and measure the cost of an empty probe, which is removed from every measurement.
+ * Called after SWTIMER_init.
+ */
+void PROF_init (void)
+{
+	uint32 start = 0;
+
+	start = TIME_nowTicks ();
+	g_overhead = TIME_nowTicks () - start;
+	PROF_reset ();
+}
+
+void PROF_begin (PROF_ProbeId id)
+{
+	g_probes[id].start = TIME_nowTicks ();
+}
+
+void PROF_end (PROF_ProbeId id)
+{
+	PROF_ProbeType *probe = &g_probes[id];
+	uint32 elapsed = TIME_nowTicks () - probe -> start;
+
+	elapsed = (elapsed > g_overhead) ? (elapsed - g_overhead) : 0;
+	if (probe -> count == 0xFFFF)
+	{
+		return;                                         /* Full, keep the mean correct */
+	}
+	if ((probe -> count == 0) || (elapsed < probe -> min))
+	{
+		probe -> min = elapsed;
+	}
+	if (elapsed > probe -> max)
+	{
+		probe -> max = elapsed;
+	}
+	probe -> total += elapsed;
+	probe -> count++;
+}
+
+/*
+ * Description:
+ * Send one LINK_MSG_PROFILE_REPORT frame for every probe, then clear the table.
+ */
+void PROF_dump (void)
+{
+	uint8 id = 0;
+	uint8 report [PROF_REPORT_LENGTH];
+	const PROF_ProbeType *probe;
+
+	for (id = 0; id < PROF_PROBES_COUNT; id++)
+	{
+		probe = &g_probes[id];
+		report[0] = id;
+		report[1] = (uint8)(probe -> count >> 8);
+		report[2] = (uint8)probe -> count;
+		PROF_putLong (&report[3], probe -> min * PROF_CYCLES_PER_TICK);
+		PROF_putLong (&report[7], probe -> max * PROF_CYCLES_PER_TICK);
+		PROF_putLong (&report[11], (probe -> count == 0) ? 0 :
+				(probe -> total / probe -> count) * PROF_CYCLES_PER_TICK);
+		LINK_sendFrame (LINK_MSG_PROFILE_REPORT, report, PROF_REPORT_LENGTH);
+	}
+	PROF_reset ();
+}
+
+static void PROF_reset (void)
+{
+	uint8 id = 0;
+
+	for (id = 0; id < PROF_PROBES_COUNT; id++)
+	{
+		g_probes[id].min = 0;
+		g_probes[id].max = 0;
+		g_probes[id].total = 0;
+		g_probes[id].count = 0;
+	}
+}
+
+static void PROF_putLong (uint8 *buffer, uint32 value)
+{
+	buffer[0] = (uint8)(value >> 24);
+	buffer[1] = (uint8)(value >> 16);
+	buffer[2] = (uint8)(value >> 8);
+	buffer[3] = (uint8)value;
+}
+
+#endif /* PROF_ENABLE */
@@ -0,0 +1,204 @@
+/******************************************************************************
+ *
+ * Module: Software Timers
+ *
+ * File Name: sw_timer.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the software timers multiplexed on the Timer1 tick
+ *
+ *******************************************************************************/
+
+#include "sw_timer.h"
+#include "timer1.h"
+#include <util/atomic.h>
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+
+/*
+ * Hashed timing wheel: a timer due in d ticks hangs from slot (cursor + d) mod size
+ * with (d - 1) / size rounds left, so each tick visits only the timers of one slot.
+ */
+static SWTIMER_LinkType g_wheel [SWTIMER_WHEEL_SIZE];
+static uint8 g_cursor = 0;
+
+/* Ticks since SWTIMER_init, the base of the uptime clock */
+static volatile uint32 g_tickCount = 0;
+
+/* Timer1 tick, derived from F_CPU at compile time */
+static const TIMER1_ConfigType s_tickConfiguration = TIMER1_CONFIG (SWTIMER_TICK_MS);
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Timer1 call back, advance the wheel by one slot and expire its due timers */
+static void SWTIMER_tick (void);
+
+/* Hang the timer in the slot it is due in after ticks */
+static void SWTIMER_insert (SWTIMER_TimerType *timer, uint16 ticks);
+
+/* Unlink the node from its circular list */
+static void SWTIMER_unlink (SWTIMER_LinkType *node);
+
+/* Link the node at the tail of the circular list of head */
+static void SWTIMER_append (SWTIMER_LinkType *head, SWTIMER_LinkType *node);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * 1. Empty the timing wheel.
+ * 2. Start Timer1 in compare mode with a SWTIMER_TICK_MS interrupt.
+ */
+void SWTIMER_init (void)
+{
+	uint8 i = 0;
+
+	for (i = 0; i < SWTIMER_WHEEL_SIZE; i++)
+	{
+		g_wheel[i].next = &g_wheel[i];
+		g_wheel[i].prev = &g_wheel[i];
+	}
+	g_cursor = 0;
+	g_tickCount = 0;
+
+	TIMER1_setCallBack (SWTIMER_tick);
+	TIMER1_init (&s_tickConfiguration);
+}
+
+/*
+ * Description:
+ * Arm the timer to call a_ptr after timeoutMs (rounded up to the tick), then every timeoutMs
+ * if the mode is periodic. Restart it if it is already armed. O(1).
+ * The call back runs from the Timer1 ISR and may start or stop any timer.
+ */
+void SWTIMER_start (SWTIMER_TimerType *timer, uint32 timeoutMs, SWTIMER_Mode mode, void (*a_ptr)(void))
+{
+	uint16 ticks = 0;
+
+	if (timeoutMs > SWTIMER_MAX_TIMEOUT_MS)
+	{
+		timeoutMs = SWTIMER_MAX_TIMEOUT_MS;
+	}
+	ticks = (uint16)((timeoutMs + SWTIMER_TICK_MS - 1) / SWTIMER_TICK_MS);
+	if (ticks == 0)
+	{
+		ticks = 1;                                      /* Expire on the next tick */
+	}
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		SWTIMER_stop (timer);
+		timer -> callBack = a_ptr;
+		timer -> periodTicks = (mode == SWTIMER_PERIODIC) ? ticks : 0;
+		SWTIMER_insert (timer, ticks);
+	}
+}
+
+/*
+ * Description:
+ * Cancel the timer if it is armed. O(1).
+ */
+void SWTIMER_stop (SWTIMER_TimerType *timer)
+{
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		if (timer -> link.next != NULL_PTR)
+		{
+			SWTIMER_unlink (&timer -> link);
+		}
+	}
+}
+
+/*
+ * Description:
+ * Return TRUE if the timer is armed.
+ */
+bool SWTIMER_isActive (const SWTIMER_TimerType *timer)
+{
+	return (timer -> link.next != NULL_PTR);
+}
+
+/*
+ * Description:
+ * Return the number of ticks since SWTIMER_init, wraps around after 2^32 ticks.
+ */
+uint32 SWTIMER_getTickCount (void)
+{
+	uint32 count = 0;
+
+	ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+	{
+		count = g_tickCount;
+	}
+	return count;
+}
+
+static void SWTIMER_tick (void)
+{
+	SWTIMER_LinkType expired;
+	SWTIMER_LinkType *node;
+	SWTIMER_LinkType *next;
+	SWTIMER_TimerType *timer;
+
+	g_tickCount++;
+	g_cursor = (g_cursor + 1) & (SWTIMER_WHEEL_SIZE - 1);
+
+	/* Move the due timers to a local list first, the call backs may change the wheel */
+	expired.next = &expired;
+	expired.prev = &expired;
+	for (node = g_wheel[g_cursor].next; node != &g_wheel[g_cursor]; node = next)
+	{
+		next = node -> next;
+		timer = (SWTIMER_TimerType *)node;
+		if (timer -> rounds != 0)
+		{
+			timer -> rounds--;
+		}
+		else
+		{
+			SWTIMER_unlink (node);
+			SWTIMER_append (&expired, node);
+		}
+	}
+
+	/* A call back stopping a timer still in the local list unlinks it from there */
+	while (expired.next != &expired)
+	{
+		timer = (SWTIMER_TimerType *)expired.next;
+		SWTIMER_unlink (&timer -> link);
+		if (timer -> periodTicks != 0)
+		{
+			SWTIMER_insert (timer, timer -> periodTicks);
+		}
+		(*timer -> callBack)();
+	}
+}
+
+static void SWTIMER_insert (SWTIMER_TimerType *timer, uint16 ticks)
+{
+	timer -> rounds = (ticks - 1) / SWTIMER_WHEEL_SIZE;
+	SWTIMER_append (&g_wheel[(g_cursor + ticks) & (SWTIMER_WHEEL_SIZE - 1)], &timer -> link);
+}
+
+static void SWTIMER_unlink (SWTIMER_LinkType *node)
+{
+	node -> prev -> next = node -> next;
+	node -> next -> prev = node -> prev;
+	node -> next = NULL_PTR;                            /* Marks the timer as not armed */
+	node -> prev = NULL_PTR;
+}
+
+static void SWTIMER_append (SWTIMER_LinkType *head, SWTIMER_LinkType *node)
+{
+	node -> next = head;
+	node -> prev = head -> prev;
+	head -> prev -> next = node;
+	head -> prev = node;
+}
@@ -22,25 +22,37 @@
  *                                    Globals                                  *
  *******************************************************************************/
 static volatile void (*g_callBack_Ptr)(void) = NULL_PTR;
+static volatile uint8 g_isrCount = 1;       /* Interrupts per call back */
+static volatile uint8 g_isrCounter = 0;     /* Interrupts since the last call back */
 
 /*******************************************************************************
  *                                    ISR                                      *
  *******************************************************************************/
 
-/* For calling the call back functions */
+/* For calling the call back functions every g_isrCount interrupts */
 ISR (TIMER1_COMPA_vect)
 {
-	if (g_callBack_Ptr != NULL_PTR)
+	g_isrCounter++;
+	if (g_isrCounter >= g_isrCount)
+	{
+		g_isrCounter = 0;
+		if (g_callBack_Ptr != NULL_PTR)
 		{
 			(*g_callBack_Ptr)();
 		}
+	}
 }
 
 ISR (TIMER1_OVF_vect)
 {
-	if (g_callBack_Ptr != NULL_PTR)
+	g_isrCounter++;
+	if (g_isrCounter >= g_isrCount)
 	{
-		(*g_callBack_Ptr)();
+		g_isrCounter = 0;
+		if (g_callBack_Ptr != NULL_PTR)
+		{
+			(*g_callBack_Ptr)();
+		}
 	}
 }
 
@@ -55,11 +67,14 @@ ISR (TIMER1_OVF_vect)
  * 2. Set the compare value if needed.
  * 3. Select the required pre-scaler.
  * 4. Select the timer mode.
+ * 5. Set the number of interrupts per call back.
  */
 void TIMER1_init(const TIMER1_ConfigType * Config_Ptr)
 {
-	TCCR1A = 0x0C;       											/* For selecting non_PWM mode */
-	TCCR1B = ((Config_Ptr -> mode) & 0x0F) << 4;        			/* For selecting the mode */
+	g_isrCount = (Config_Ptr -> isr_count == 0) ? 1 : Config_Ptr -> isr_count;
+	g_isrCounter = 0;
+	TCCR1A = 0x0C | ((Config_Ptr -> mode) & 0x03);					/* For selecting non_PWM mode, WGM11:10 */
+	TCCR1B = ((Config_Ptr -> mode) & 0x0C) << 1;        			/* For selecting the mode, WGM13:12 */
 	TCCR1B = (TCCR1B & 0xF8) | ((Config_Ptr -> prescaler) & 0x07);	/* For selecting the pre-scaler */
 	TCNT1 = Config_Ptr -> initial_value;							/* Set the initial timer value */
 	OCR1A = Config_Ptr -> compare_value;							/* Set the required compare value */
@@ -91,3 +106,25 @@ void TIMER1_deInit(void)
 {
 	TCCR1B = (TCCR1B & 0xF8) | (0);                                 /* Stop the clock source */
 }
+
+/*
+ * Description:
+ * Function to read the Timer1 counter.
+ */
+uint16 TIMER1_getCount(void)
+{
+	return TCNT1;
+}
+
+/*
+ * Description:
+ * Function to check if the interrupt of the running mode is raised but not served yet.
+ */
+bool TIMER1_isInterruptPending(void)
+{
+	if (BIT_IS_SET(TIMSK, OCIE1A))
+	{
+		return BIT_IS_SET(TIFR, OCF1A) ? TRUE : FALSE;
+	}
+	return BIT_IS_SET(TIFR, TOV1) ? TRUE : FALSE;
+}
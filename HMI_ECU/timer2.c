@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * Module: Timer 2
+ *
+ * File Name: timer2.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the timer 2 AVR driver, compare mode only
+ *
+ *******************************************************************************/
+
+#include "timer2.h"
+#include "common_macros.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+static void (*volatile g_callBack_Ptr)(void) = NULL_PTR;
+
+/*******************************************************************************
+ *                                    ISR                                      *
+ *******************************************************************************/
+
+ISR (TIMER2_COMP_vect)
+{
+	if (g_callBack_Ptr != NULL_PTR)
+	{
+		(*g_callBack_Ptr)();
+	}
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Function to start the Timer2 driver from zero in CTC mode.
+ * 1. Set the compare value.
+ * 2. Select the required pre-scaler.
+ * 3. Enable the compare interrupt.
+ */
+void TIMER2_init(const TIMER2_ConfigType * Config_Ptr)
+{
+	TCCR2 = 0;                                                      /* Stop the clock while configuring */
+	TCNT2 = 0;
+	OCR2 = Config_Ptr -> compare_value;
+	TIFR = (1 << OCF2);                                             /* Drop a stale compare flag only, a 1 clears a flag */
+	SET_BIT(TIMSK, OCIE2);
+	TCCR2 = (1 << WGM21) | ((Config_Ptr -> prescaler) & 0x07);     /* CTC, non-PWM and the pre-scaler */
+}
+
+/*
+ * Description:
+ * Function to set the Call Back function address.
+ */
+void TIMER2_setCallBack(void(*a_ptr)(void))
+{
+	g_callBack_Ptr = a_ptr;
+}
+
+/*
+ * Description:
+ * Function to stop the Timer2 and its interrupt.
+ */
+void TIMER2_deInit(void)
+{
+	TCCR2 = 0;                                                      /* Stop the clock source */
+	CLEAR_BIT(TIMSK, OCIE2);
+}
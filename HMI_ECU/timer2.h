@@ -0,0 +1,59 @@
+/******************************************************************************
+ *
+ * Module: Timer 2
+ *
+ * File Name: timer2.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the timer 2 AVR driver, compare mode only
+ *
+ *******************************************************************************/
+
+#ifndef TIMER2_H_
+#define TIMER2_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	TIMER2_OFF, TIMER2_FCPU_1, TIMER2_FCPU_8, TIMER2_FCPU_32, TIMER2_FCPU_64, TIMER2_FCPU_128, TIMER2_FCPU_256, TIMER2_FCPU_1024
+}TIMER2_Prescaler;
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+typedef struct {
+uint8 compare_value; // interrupt every compare_value + 1 counts.
+TIMER2_Prescaler prescaler;
+} TIMER2_ConfigType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Function to start the Timer2 driver from zero in CTC mode.
+ * 1. Set the compare value.
+ * 2. Select the required pre-scaler.
+ * 3. Enable the compare interrupt.
+ */
+void TIMER2_init(const TIMER2_ConfigType * Config_Ptr);
+
+/*
+ * Description:
+ * Function to set the Call Back function address.
+ */
+void TIMER2_setCallBack(void(*a_ptr)(void));
+
+/*
+ * Description:
+ * Function to stop the Timer2 and its interrupt.
+ */
+void TIMER2_deInit(void);
+
+#endif /* TIMER2_H_ */
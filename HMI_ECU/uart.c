@@ -13,6 +13,60 @@
 #include "uart.h"
 #include "avr/io.h" /* To use the UART Registers */
 #include "common_macros.h" /* To use the macros like SET_BIT */
+#include <avr/interrupt.h> /* For UART ISRs */
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+
+/*
+ * Single producer / single consumer ring buffers.
+ * The indices are free running, the ISR owns one side and the application the
+ * other, so no critical section is needed as uint8 accesses are atomic.
+ */
+static volatile uint8 g_rxBuffer [UART_RX_BUFFER_SIZE];
+static volatile uint8 g_rxHead = 0;                 /* Written by the RX Complete ISR */
+static volatile uint8 g_rxTail = 0;                 /* Written by UART_read */
+
+static volatile uint8 g_txBuffer [UART_TX_BUFFER_SIZE];
+static volatile uint8 g_txHead = 0;                 /* Written by UART_write */
+static volatile uint8 g_txTail = 0;                 /* Written by the Data Register Empty ISR */
+
+static void (*volatile g_rxCallBack_Ptr)(void) = NULL_PTR;  /* Called for every received byte */
+
+/*******************************************************************************
+ *                                    ISR                                      *
+ *******************************************************************************/
+
+/* Move the received byte to the RX ring buffer, drop it if the buffer is full */
+ISR (USART_RXC_vect)
+{
+	uint8 data = UDR;                               /* Reading UDR clears the RXC flag */
+
+	if ((uint8)(g_rxHead - g_rxTail) < UART_RX_BUFFER_SIZE)
+	{
+		g_rxBuffer[g_rxHead & (UART_RX_BUFFER_SIZE - 1)] = data;
+		g_rxHead++;
+	}
+	if (g_rxCallBack_Ptr != NULL_PTR)
+	{
+		(*g_rxCallBack_Ptr)();
+	}
+}
+
+/* Feed UDR from the TX ring buffer and stop the interrupt when it gets empty */
+ISR (USART_UDRE_vect)
+{
+	if (g_txHead != g_txTail)
+	{
+		UDR = g_txBuffer[g_txTail & (UART_TX_BUFFER_SIZE - 1)];
+		g_txTail++;
+	}
+	else
+	{
+		CLEAR_BIT (UCSRB, UDRIE);
+	}
+}
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -22,8 +76,10 @@
  * Description :
  * Functional responsible for Initialize the UART device by:
  * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
- * 2. Enable the UART.
+ * 2. Enable the UART with the RX Complete interrupt.
  * 3. Setup the UART baud rate.
+ * 4. Empty the RX and TX ring buffers.
+ * The I-bit must be enabled before using the driver as the data moves through the interrupts.
  */
 void UART_init(const UART_ConfigType* Config_Ptr)
 {
@@ -32,16 +88,22 @@ void UART_init(const UART_ConfigType* Config_Ptr)
 	/* U2X = 1 for double transmission speed */
 	UCSRA = (1<<U2X);
 
+	/* Start with empty ring buffers */
+	g_rxHead = 0;
+	g_rxTail = 0;
+	g_txHead = 0;
+	g_txTail = 0;
+
 	/************************** UCSRB Description **************************
-	 * RXCIE = 0 Disable USART RX Complete Interrupt Enable
+	 * RXCIE = 1 Enable USART RX Complete Interrupt Enable
 	 * TXCIE = 0 Disable USART Tx Complete Interrupt Enable
-	 * UDRIE = 0 Disable USART Data Register Empty Interrupt Enable
+	 * UDRIE = 0 Disable USART Data Register Empty Interrupt Enable (enabled by UART_write)
 	 * RXEN  = 1 Receiver Enable
 	 * RXEN  = 1 Transmitter Enable
 	 * UCSZ2 = 0 For 8-bit data mode
 	 * RXB8 & TXB8 not used for 8-bit data mode
 	 ***********************************************************************/ 
-	UCSRB = (1<<RXEN) | (1<<TXEN);
+	UCSRB = (1<<RXCIE) | (1<<RXEN) | (1<<TXEN);
 	
 	/************************** UCSRC Description **************************
 	 * URSEL   = 1 The URSEL must be one when writing the UCSRC
@@ -66,86 +128,86 @@ void UART_init(const UART_ConfigType* Config_Ptr)
 
 /*
  * Description :
- * Functional responsible for send byte to another UART device.
+ * Non-blocking write, copy up to size bytes into the TX ring buffer and start the transmission.
+ * Return the number of bytes queued, which is less than size if the buffer is full.
  */
-void UART_sendByte(const uint8 data)
+uint8 UART_write(const uint8 *data, uint8 size)
 {
-	/*
-	 * UDRE flag is set when the Tx buffer (UDR) is empty and ready for
-	 * transmitting a new byte so wait until this flag is set to one
-	 */
-	while(BIT_IS_CLEAR(UCSRA,UDRE)){}
-
-	/*
-	 * Put the required data in the UDR register and it also clear the UDRE flag as
-	 * the UDR register is not empty now
-	 */
-	UDR = data;
-
-	/************************* Another Method *************************
-	UDR = data;
-	while(BIT_IS_CLEAR(UCSRA,TXC)){} // Wait until the transmission is complete TXC = 1
-	SET_BIT(UCSRA,TXC); // Clear the TXC flag
-	*******************************************************************/
-}
+	uint8 i = 0;
 
-/*
- * Description :
- * Functional responsible for receive byte from another UART device.
- */
-uint8 UART_recieveByte(void)
-{
-	/* RXC flag is set when the UART receive data so wait until this flag is set to one */
-	while(BIT_IS_CLEAR(UCSRA,RXC)){}
-
-	/*
-	 * Read the received data from the Rx buffer (UDR)
-	 * The RXC flag will be cleared after read the data
-	 */
-    return UDR;		
+	while ((i < size) && ((uint8)(g_txHead - g_txTail) < UART_TX_BUFFER_SIZE))
+	{
+		g_txBuffer[g_txHead & (UART_TX_BUFFER_SIZE - 1)] = data[i];
+		g_txHead++;
+		i++;
+	}
+
+	/* The UDRE interrupt fires as long as UDR is empty, so enabling it starts the transmission */
+	if (i != 0)
+	{
+		SET_BIT (UCSRB, UDRIE);
+	}
+	return i;
 }
 
 /*
  * Description :
- * Send the required string through UART to the other UART device.
+ * Non-blocking read, move up to size received bytes from the RX ring buffer to data.
+ * Return the number of bytes copied, zero if nothing was received.
  */
-void UART_sendString(const uint8 *Str)
+uint8 UART_read(uint8 *data, uint8 size)
 {
 	uint8 i = 0;
 
-	/* Send the whole string */
-	while(Str[i] != '\0')
+	while ((i < size) && (g_rxTail != g_rxHead))
 	{
-		UART_sendByte(Str[i]);
+		data[i] = g_rxBuffer[g_rxTail & (UART_RX_BUFFER_SIZE - 1)];
+		g_rxTail++;
 		i++;
 	}
-	/************************* Another Method *************************
-	while(*Str != '\0')
-	{
-		UART_sendByte(*Str);
-		Str++;
-	}		
-	*******************************************************************/
+	return i;
 }
 
 /*
  * Description :
- * Receive the required string until the '#' symbol through UART from the other UART device.
+ * Set the function called from the RX Complete ISR after every received byte,
+ * NULL_PTR to remove it. It must be short as it runs inside the ISR.
  */
-void UART_receiveString(uint8 *Str)
+void UART_setRxCallBack(void(*a_ptr)(void))
 {
-	uint8 i = 0;
+	g_rxCallBack_Ptr = a_ptr;
+}
+
+/*
+ * Description :
+ * Return the number of received bytes waiting in the RX ring buffer.
+ */
+uint8 UART_available(void)
+{
+	return (uint8)(g_rxHead - g_rxTail);
+}
 
-	/* Receive the first byte */
-	Str[i] = UART_recieveByte();
+/*
+ * Description :
+ * Functional responsible for send byte to another UART device.
+ * Wait only if the TX ring buffer is full.
+ */
+void UART_sendByte(const uint8 data)
+{
+	/* The Data Register Empty ISR frees a place in the buffer every byte time */
+	while (UART_write(&data, 1) == 0){}
+}
 
-	/* Receive the whole string until the '#' */
-	while(Str[i] != '#')
-	{
-		i++;
-		Str[i] = UART_recieveByte();
-	}
+/*
+ * Description :
+ * Functional responsible for receive byte from another UART device.
+ * Wait until a byte is available in the RX ring buffer.
+ */
+uint8 UART_recieveByte(void)
+{
+	uint8 data;
 
-	/* After receiving the whole string plus the '#', replace the '#' with '\0' */
-	Str[i] = '\0';
+	/* The RX Complete ISR fills the buffer, so no byte is lost while waiting here */
+	while (UART_read(&data, 1) == 0){}
+	return data;
 }
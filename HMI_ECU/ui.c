@@ -0,0 +1,515 @@
+/******************************************************************************
+ *
+ * Module: UI
+ *
+ * File Name: ui.c
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Source file for the event driven screens of the HMI
+ *
+ *******************************************************************************/
+
+#include "ui.h"
+#include "lcd.h"
+#include "sw_timer.h"
+#include "profiler.h"
+#include "idle.h"
+#include "uptime.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                     Structures And Unions                                   *
+ *******************************************************************************/
+
+/* The whole state of the HMI */
+typedef struct
+{
+	UI_State state;
+	uint8 action;                   /* '+' open door or '-' change password */
+	uint8 keys;                     /* Keys of the entry being typed */
+	uint8 echoCol;                  /* Column of the '*' of the first key, on the second row */
+	/* New password frame payload: sequence, first entry length, first entry, confirmation entry */
+	uint8 newPassword [2 + (2 * UI_PASSWORD_MAX_KEYS)];
+	/* Authenticate frame payload: sequence, action, password entry */
+	uint8 password [2 + UI_PASSWORD_MAX_KEYS];
+	SWTIMER_TimerType timer;        /* Times the door and warning screens, the replies and the handshake retries */
+	/* Request waiting for its reply, kept to send it again */
+	uint8 requestType;
+	uint8 requestSequence;          /* Sequence of the last new request */
+	const uint8 *request;
+	uint8 requestLength;
+	uint8 retries;                  /* Sends left before the no reply error */
+	UI_State errorReturn;           /* Screen after the no reply error */
+	uint16 bootMs;                  /* Uptime when the first screen was ready */
+	uint16 controlBootMs;           /* Uptime of control_ECU when its password was loaded */
+	void (*timerCallBack)(void);
+} UI_ContextType;
+
+/*******************************************************************************
+ *                                    Globals                                  *
+ *******************************************************************************/
+static UI_ContextType g_ui;
+
+/* Screen strings, kept in the flash to leave the SRAM for the buffers */
+static const char g_enterPasswordText[] PROGMEM = "PLZ ENTER PASS:";
+static const char g_reEnterText[] PROGMEM = "PLZ RE-ENTER THE";
+static const char g_samePasswordText[] PROGMEM = "SAME PASS: ";
+static const char g_openDoorText[] PROGMEM = "+ : OPEN DOOR";
+static const char g_changePasswordText[] PROGMEM = "- : CHANGE PASS";
+static const char g_doorIsText[] PROGMEM = "DOOR IS";
+static const char g_unlockingText[] PROGMEM = "UNLOCKING";
+static const char g_unlockedText[] PROGMEM = "UNLOCKED";
+static const char g_lockingText[] PROGMEM = "LOCKING";
+static const char g_thiefText[] PROGMEM = "THIEF!";
+static const char g_echoText[] PROGMEM = "*";
+static const char g_pleaseWaitText[] PROGMEM = "PLEASE WAIT";
+static const char g_noReplyText[] PROGMEM = "NO REPLY";
+static const char g_tryAgainText[] PROGMEM = "TRY AGAIN";
+static const char g_noControlUnitText[] PROGMEM = "NO CONTROL UNIT";
+static const char g_retryingText[] PROGMEM = "RETRYING...";
+
+static const LCD_ScreenItemType g_enterPasswordScreen[] PROGMEM =
+{
+	{0, 0, g_enterPasswordText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_confirmPasswordScreen[] PROGMEM =
+{
+	{0, 0, g_reEnterText}, {1, 0, g_samePasswordText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_mainMenuScreen[] PROGMEM =
+{
+	{0, 0, g_openDoorText}, {1, 0, g_changePasswordText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_unlockingScreen[] PROGMEM =
+{
+	{0, 5, g_doorIsText}, {1, 4, g_unlockingText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_unlockedScreen[] PROGMEM =
+{
+	{0, 5, g_doorIsText}, {1, 4, g_unlockedText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_lockingScreen[] PROGMEM =
+{
+	{0, 4, g_doorIsText}, {1, 4, g_lockingText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_lockoutScreen[] PROGMEM =
+{
+	{0, 5, g_thiefText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_startingScreen[] PROGMEM =
+{
+	{0, 2, g_pleaseWaitText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_noReplyScreen[] PROGMEM =
+{
+	{0, 4, g_noReplyText}, {1, 3, g_tryAgainText}, {0, 0, NULL_PTR}
+};
+static const LCD_ScreenItemType g_noControllerScreen[] PROGMEM =
+{
+	{0, 0, g_noControlUnitText}, {1, 2, g_retryingText}, {0, 0, NULL_PTR}
+};
+
+/* Drawing of every state, NULL_PTR for the waiting screens keeping the last drawing */
+static const LCD_ScreenItemType * const g_screens[] PROGMEM =
+{
+	g_enterPasswordScreen,          /* UI_STATE_NEW_PASSWORD */
+	g_confirmPasswordScreen,        /* UI_STATE_CONFIRM_PASSWORD */
+	NULL_PTR,                       /* UI_STATE_WAIT_SAVE */
+	g_mainMenuScreen,               /* UI_STATE_MAIN_MENU */
+	g_enterPasswordScreen,          /* UI_STATE_ENTER_PASSWORD */
+	NULL_PTR,                       /* UI_STATE_WAIT_AUTHENTICATION */
+	g_unlockingScreen,              /* UI_STATE_UNLOCKING */
+	g_unlockedScreen,               /* UI_STATE_UNLOCKED */
+	g_lockingScreen,                /* UI_STATE_LOCKING */
+	g_lockoutScreen,                /* UI_STATE_LOCKOUT */
+	g_startingScreen,               /* UI_STATE_STARTING */
+	g_noReplyScreen,                /* UI_STATE_NO_REPLY */
+	g_noControllerScreen            /* UI_STATE_NO_CONTROLLER */
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/* Switch to the screen, draw it in the frame buffer and start its timer if it has one */
+static void UI_enter (UI_State state);
+
+/*
+ * Send the request and wait for its reply in the waiting state, it is sent again
+ * if no reply comes and errorReturn is shown after the no reply error.
+ */
+static void UI_sendRequest (uint8 type, uint8 *payload, uint8 length, UI_State waiting, UI_State errorReturn);
+
+/* Leave the startup screen for the first real one and note the boot time */
+static void UI_ready (UI_State state);
+
+/* Return the screen following a status frame of control_ECU */
+static UI_State UI_statusState (const LINK_FrameType *frame);
+
+/* Send the boot times of both ECUs, HMI_ECU then control_ECU, in ms, and the budget overrun */
+static void UI_sendBootReport (void);
+
+/* Send the profiler, the idle statistics and the boot times of HMI_ECU */
+static void UI_dumpReports (void);
+
+/*
+ * Add the key to the entry at buffer and show '*' for it.
+ * Return TRUE when the entry ends, the enter key is not stored.
+ */
+static bool UI_addKey (uint8 *buffer, uint8 key);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Start the handshake with control_ECU, the main menu follows if it holds a password
+ * and the new password screen otherwise. timerCallBack is called from the Timer1 ISR when
+ * the screen timer expires, it must lead to UI_timerExpired out of the ISR.
+ */
+void UI_init (void (*timerCallBack)(void))
+{
+	g_ui.timerCallBack = timerCallBack;
+	g_ui.bootMs = 0;
+	g_ui.controlBootMs = 0;
+	g_ui.retries = UI_STARTING_TIMEOUT_MS / UI_HELLO_RETRY_MS;
+	UI_enter (UI_STATE_STARTING);
+}
+
+/*
+ * Description:
+ * Handle one pressed key, the keys are ignored on the screens not waiting for one.
+ */
+void UI_keyPressed (uint8 key)
+{
+	switch (g_ui.state)
+	{
+	case UI_STATE_NEW_PASSWORD:
+		if (UI_addKey (&g_ui.newPassword[2], key))
+		{
+			g_ui.newPassword[1] = g_ui.keys;
+			UI_enter (UI_STATE_CONFIRM_PASSWORD);
+		}
+		break;
+
+	case UI_STATE_CONFIRM_PASSWORD:
+		if (UI_addKey (&g_ui.newPassword[2 + g_ui.newPassword[1]], key))
+		{
+			/* Send the 2 passwords to control_ECU and wait for confirmation */
+			UI_sendRequest (LINK_MSG_NEW_PASSWORD, g_ui.newPassword, 2 + g_ui.newPassword[1] + g_ui.keys,
+							UI_STATE_WAIT_SAVE, UI_STATE_NEW_PASSWORD);
+		}
+		break;
+
+	case UI_STATE_MAIN_MENU:
+		if ((key == '+') || (key == '-'))
+		{
+			g_ui.action = key;
+			UI_enter (UI_STATE_ENTER_PASSWORD);
+		}
+		break;
+
+	case UI_STATE_ENTER_PASSWORD:
+		if (UI_addKey (&g_ui.password[2], key))
+		{
+			g_ui.password[1] = g_ui.action;
+			UI_sendRequest (LINK_MSG_AUTHENTICATE, g_ui.password, 2 + g_ui.keys,
+							UI_STATE_WAIT_AUTHENTICATION, UI_STATE_MAIN_MENU);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+ * Description:
+ * Handle one long pressed key, only UI_PROFILE_KEY on the main menu is used.
+ */
+void UI_keyLongPressed (uint8 key)
+{
+	/* The short press of the key came first, the main menu ignored it */
+	if ((g_ui.state == UI_STATE_MAIN_MENU) && (key == UI_PROFILE_KEY))
+	{
+		LINK_sendFrame (LINK_MSG_PROFILE_REQUEST, NULL_PTR, 0);
+		UI_dumpReports ();
+	}
+}
+
+/*
+ * Description:
+ * Handle one frame from control_ECU, the replies are ignored on the screens not waiting for one.
+ */
+void UI_frameReceived (const LINK_FrameType *frame)
+{
+	if (frame -> type == LINK_MSG_PROFILE_REQUEST)
+	{
+		UI_dumpReports ();
+		return;
+	}
+
+	switch (g_ui.state)
+	{
+	case UI_STATE_STARTING:
+	case UI_STATE_NO_CONTROLLER:
+		/* Status payload: LINK_STATUS_xxx, control_ECU boot ms high byte, low byte */
+		if ((frame -> type == LINK_MSG_STATUS) && (frame -> length == 3))
+		{
+			g_ui.controlBootMs = ((uint16)frame -> payload[1] << 8) | frame -> payload[2];
+			UI_ready (UI_statusState (frame));
+		}
+		break;
+
+	case UI_STATE_WAIT_SAVE:
+		if (frame -> type == LINK_MSG_CONFIRM)
+		{
+			UI_enter (UI_STATE_MAIN_MENU);
+		}
+		else if ((frame -> type == LINK_MSG_WRONG) || (frame -> type == LINK_MSG_REPEAT))
+		{
+			UI_enter (UI_STATE_NEW_PASSWORD);
+		}
+		else if (frame -> type == LINK_MSG_STATUS)
+		{
+			UI_enter (UI_statusState (frame));          /* control_ECU was not expecting a new password */
+		}
+		break;
+
+	case UI_STATE_WAIT_AUTHENTICATION:
+		/* Depending on the received message:
+		 * 1. If confirm, open the door or change the password.
+		 * 2. If repeat, ask for the password again.
+		 * 3. If wrong after 3 iterations, display the warning message.
+		 */
+		if (frame -> type == LINK_MSG_CONFIRM)
+		{
+			UI_enter ((g_ui.action == '+') ? UI_STATE_UNLOCKING : UI_STATE_NEW_PASSWORD);
+		}
+		else if (frame -> type == LINK_MSG_REPEAT)
+		{
+			UI_enter (UI_STATE_ENTER_PASSWORD);
+		}
+		else if (frame -> type == LINK_MSG_WRONG)
+		{
+			UI_enter (UI_STATE_LOCKOUT);
+		}
+		else if (frame -> type == LINK_MSG_STATUS)
+		{
+			UI_enter (UI_statusState (frame));          /* control_ECU was not expecting a password */
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+ * Description:
+ * Handle the expiry of the screen timer.
+ */
+void UI_timerExpired (void)
+{
+	switch (g_ui.state)
+	{
+	case UI_STATE_UNLOCKING:
+		UI_enter (UI_STATE_UNLOCKED);
+		break;
+
+	case UI_STATE_UNLOCKED:
+		UI_enter (UI_STATE_LOCKING);
+		break;
+
+	case UI_STATE_LOCKING:
+	case UI_STATE_LOCKOUT:
+		UI_enter (UI_STATE_MAIN_MENU);
+		break;
+
+	case UI_STATE_WAIT_SAVE:
+	case UI_STATE_WAIT_AUTHENTICATION:
+		if (g_ui.retries == 0)
+		{
+			UI_enter (UI_STATE_NO_REPLY);
+		}
+		else
+		{
+			/* The request or its reply was lost, a dropped frame is never answered */
+			g_ui.retries--;
+			LINK_sendFrame (g_ui.requestType, g_ui.request, g_ui.requestLength);
+			SWTIMER_start (&g_ui.timer, UI_REPLY_TIMEOUT_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		}
+		break;
+
+	case UI_STATE_NO_REPLY:
+		UI_enter (g_ui.errorReturn);
+		break;
+
+	case UI_STATE_STARTING:
+		/* Only control_ECU knows if a password is stored, a guessed screen could wait for a reply forever */
+		if (g_ui.retries == 0)
+		{
+			UI_enter (UI_STATE_NO_CONTROLLER);          /* Shows the error and keeps sending the handshake */
+			break;
+		}
+		g_ui.retries--;
+		/* fall through */
+
+	case UI_STATE_NO_CONTROLLER:
+		LINK_sendFrame (LINK_MSG_HELLO, NULL_PTR, 0);
+		SWTIMER_start (&g_ui.timer, UI_HELLO_RETRY_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+ * Description:
+ * Return the current screen.
+ */
+UI_State UI_getState (void)
+{
+	return g_ui.state;
+}
+
+static void UI_enter (UI_State state)
+{
+	const LCD_ScreenItemType *screen;
+
+	g_ui.state = state;
+	g_ui.keys = 0;
+	SWTIMER_stop (&g_ui.timer);                         /* A timer of the previous screen must not expire here */
+
+	screen = pgm_read_ptr (&g_screens[state]);
+	if (screen != NULL_PTR)
+	{
+		LCD_bufScreen_P (screen);
+	}
+
+	switch (state)
+	{
+	case UI_STATE_NEW_PASSWORD:
+	case UI_STATE_ENTER_PASSWORD:
+		g_ui.echoCol = 0;
+		break;
+
+	case UI_STATE_CONFIRM_PASSWORD:
+		g_ui.echoCol = 10;
+		break;
+
+	case UI_STATE_UNLOCKING:
+		SWTIMER_start (&g_ui.timer, UI_DOOR_UNLOCKING_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		break;
+
+	case UI_STATE_UNLOCKED:
+		SWTIMER_start (&g_ui.timer, UI_DOOR_HOLD_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		break;
+
+	case UI_STATE_LOCKING:
+		SWTIMER_start (&g_ui.timer, UI_DOOR_LOCKING_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		break;
+
+	case UI_STATE_LOCKOUT:
+		SWTIMER_start (&g_ui.timer, UI_LOCKOUT_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		break;
+
+	case UI_STATE_WAIT_SAVE:
+	case UI_STATE_WAIT_AUTHENTICATION:
+		SWTIMER_start (&g_ui.timer, UI_REPLY_TIMEOUT_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		break;
+
+	case UI_STATE_NO_REPLY:
+		SWTIMER_start (&g_ui.timer, UI_NO_REPLY_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		break;
+
+	case UI_STATE_STARTING:
+	case UI_STATE_NO_CONTROLLER:
+		LINK_sendFrame (LINK_MSG_HELLO, NULL_PTR, 0);
+		SWTIMER_start (&g_ui.timer, UI_HELLO_RETRY_MS, SWTIMER_ONE_SHOT, g_ui.timerCallBack);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void UI_sendRequest (uint8 type, uint8 *payload, uint8 length, UI_State waiting, UI_State errorReturn)
+{
+	/* A new sequence per request, the resends of UI_timerExpired keep it */
+	g_ui.requestSequence++;
+	payload[LINK_REQUEST_SEQUENCE_OFFSET] = g_ui.requestSequence;
+	g_ui.requestType = type;
+	g_ui.request = payload;
+	g_ui.requestLength = length;
+	g_ui.retries = UI_REQUEST_RETRIES;
+	g_ui.errorReturn = errorReturn;
+	LINK_sendFrame (type, payload, length);
+	UI_enter (waiting);
+}
+
+static void UI_ready (UI_State state)
+{
+	uint32 now = 0;
+
+	UI_enter (state);
+	now = TIME_nowMs ();
+	g_ui.bootMs = (now > 0xFFFF) ? 0xFFFF : (uint16)now;
+}
+
+static UI_State UI_statusState (const LINK_FrameType *frame)
+{
+	if (frame -> length == 0)
+	{
+		return UI_STATE_NEW_PASSWORD;
+	}
+
+	switch (frame -> payload[0])
+	{
+	case LINK_STATUS_READY:
+		return UI_STATE_MAIN_MENU;
+
+	case LINK_STATUS_LOCKING:
+		return UI_STATE_LOCKING;                        /* Back to the main menu once the door is locked */
+
+	case LINK_STATUS_LOCKOUT:
+		return UI_STATE_LOCKOUT;
+
+	default:
+		return UI_STATE_NEW_PASSWORD;
+	}
+}
+
+static void UI_sendBootReport (void)
+{
+	uint8 report [5];
+
+	report[0] = (uint8)(g_ui.bootMs >> 8);
+	report[1] = (uint8)g_ui.bootMs;
+	report[2] = (uint8)(g_ui.controlBootMs >> 8);
+	report[3] = (uint8)g_ui.controlBootMs;
+	report[4] = (g_ui.bootMs > UI_BOOT_BUDGET_MS) ? 1 : 0;
+	LINK_sendFrame (LINK_MSG_BOOT_REPORT, report, 5);
+}
+
+static void UI_dumpReports (void)
+{
+	PROF_dump ();
+	IDLE_dump ();
+	UI_sendBootReport ();
+}
+
+static bool UI_addKey (uint8 *buffer, uint8 key)
+{
+	if (key == UI_ENTER_KEY)
+	{
+		return TRUE;
+	}
+	LCD_bufPrint_P (1, g_ui.echoCol + g_ui.keys, g_echoText);
+	buffer[g_ui.keys] = key;
+	g_ui.keys++;
+	return (g_ui.keys == UI_PASSWORD_MAX_KEYS);
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+ *
+ * Module: UI
+ *
+ * File Name: ui.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the event driven screens of the HMI
+ *
+ *******************************************************************************/
+
+#ifndef UI_H_
+#define UI_H_
+
+#include "std_types.h"
+#include "link.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define UI_PASSWORD_MAX_KEYS           6        /* An entry ends on the enter key or after this number of keys */
+#define UI_ENTER_KEY                   13       /* ASCII of Enter */
+#define UI_PROFILE_KEY                 '%'      /* Held on the main menu, dumps the profilers of both ECUs */
+#define UI_DOOR_UNLOCKING_MS           15000    /* Door is unlocking message */
+#define UI_DOOR_HOLD_MS                3000     /* Door is unlocked message */
+#define UI_DOOR_LOCKING_MS             15000    /* Door is locking message */
+#define UI_LOCKOUT_MS                  60000    /* Warning message after 3 wrong passwords */
+#define UI_REPLY_TIMEOUT_MS            300      /* A request is sent again if control_ECU did not answer by then */
+#define UI_REQUEST_RETRIES             2        /* Sends after the first one before giving up on the request */
+#define UI_NO_REPLY_MS                 2000     /* Error message before going back to the screen of the request */
+#define UI_HELLO_RETRY_MS              50       /* Startup handshake resent until control_ECU answers */
+#define UI_STARTING_TIMEOUT_MS         2000     /* No control unit error if the handshake is not answered by then */
+#define UI_BOOT_BUDGET_MS              500      /* A later first screen is flagged as an overrun in the boot report */
+
+/*******************************************************************************
+ *                               Enumerations                                  *
+ *******************************************************************************/
+typedef enum
+{
+	UI_STATE_NEW_PASSWORD,          /* Entering a new password */
+	UI_STATE_CONFIRM_PASSWORD,      /* Entering it again */
+	UI_STATE_WAIT_SAVE,             /* Waiting for control_ECU to accept the new password */
+	UI_STATE_MAIN_MENU,             /* Waiting for the open door or change password choice */
+	UI_STATE_ENTER_PASSWORD,        /* Entering the password for the chosen action */
+	UI_STATE_WAIT_AUTHENTICATION,   /* Waiting for control_ECU to check the password */
+	UI_STATE_UNLOCKING,
+	UI_STATE_UNLOCKED,
+	UI_STATE_LOCKING,
+	UI_STATE_LOCKOUT,               /* Warning after too many wrong passwords */
+	UI_STATE_STARTING,              /* Waiting for control_ECU to tell if a password is stored */
+	UI_STATE_NO_REPLY,              /* Error after a request was never answered */
+	UI_STATE_NO_CONTROLLER          /* Error while the startup handshake is not answered, it is still sent */
+} UI_State;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Start the handshake with control_ECU, the main menu follows if it holds a password
+ * and the new password screen otherwise. timerCallBack is called from the Timer1 ISR when
+ * the screen timer expires, it must lead to UI_timerExpired out of the ISR.
+ */
+void UI_init (void (*timerCallBack)(void));
+
+/*
+ * Description:
+ * Handle one pressed key, the keys are ignored on the screens not waiting for one.
+ */
+void UI_keyPressed (uint8 key);
+
+/*
+ * Description:
+ * Handle one long pressed key, only UI_PROFILE_KEY on the main menu is used.
+ */
+void UI_keyLongPressed (uint8 key);
+
+/*
+ * Description:
+ * Handle one frame from control_ECU, the replies are ignored on the screens not waiting for one.
+ */
+void UI_frameReceived (const LINK_FrameType *frame);
+
+/*
+ * Description:
+ * Handle the expiry of the screen timer.
+ */
+void UI_timerExpired (void);
+
+/*
+ * Description:
+ * Return the current screen.
+ */
+UI_State UI_getState (void);
+
+#endif /* UI_H_ */
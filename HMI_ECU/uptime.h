@@ -0,0 +1,61 @@
+/******************************************************************************
+ *
+ * Module: Uptime
+ *
+ * File Name: uptime.h
+ *
+ * Author: Mohamed Nasser
+ *
+ * Description: Header file for the monotonic uptime clock
+ *
+ *******************************************************************************/
+
+#ifndef UPTIME_H_
+#define UPTIME_H_
+
+#include "std_types.h"
+#include "sw_timer.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Timer1 counts per software timers tick and per ms, one count is the clock resolution */
+#define TIME_TICKS_PER_TIMER_TICK            (TIMER1_CFG_COMPARE (SWTIMER_TICK_MS) + 1ULL)
+#define TIME_TICKS_PER_MS                    (TIMER1_CFG_COUNTS (1, TIMER1_CFG_DIVIDER (SWTIMER_TICK_MS)))
+
+#if (TIME_TICKS_PER_MS == 0 || TIME_TICKS_PER_TIMER_TICK != TIME_TICKS_PER_MS * SWTIMER_TICK_MS)
+#error "The Uptime Clock Needs A Whole Number Of Timer1 Counts Per ms"
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description:
+ * Return the Timer1 counts since SWTIMER_init, wraps around after 2^32 counts.
+ * Subtract two readings as uint32 to measure a duration.
+ */
+uint32 TIME_nowTicks (void);
+
+/*
+ * Description:
+ * Return the ms since SWTIMER_init, wraps around after 2^32 ms.
+ */
+uint32 TIME_nowMs (void);
+
+/*
+ * Description:
+ * Convert a number of Timer1 counts to us.
+ */
+uint32 TIME_ticksToUs (uint32 ticks);
+
+/*
+ * Description:
+ * Return TRUE if the uptime reached deadlineMs, correct across the wrap around
+ * for deadlines less than 2^31 ms away.
+ */
+bool TIME_isReached (uint32 deadlineMs);
+
+#endif /* UPTIME_H_ */